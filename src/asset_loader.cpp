@@ -0,0 +1,40 @@
+#include "asset_loader.h"
+
+void AssetLoader::requestMesh(const char* path, unsigned int flags)
+{
+    std::shared_future<MeshData>& mesh = m_meshes[{ path, flags }];
+    if (!mesh.valid())
+    {
+        std::string pathCopy = path;
+        mesh = m_pool.submit([pathCopy, flags]() { return Model::loadMesh(pathCopy.c_str(), flags); });
+    }
+}
+
+std::shared_future<ImageData> AssetLoader::requestImage(const char* path, bool allowCompressed)
+{
+    std::shared_future<ImageData>& image = m_images[{ path, allowCompressed }];
+    if (!image.valid())
+    {
+        std::string pathCopy = path;
+        image = m_pool.submit([pathCopy, allowCompressed]() { return Texture2D::loadImage(pathCopy.c_str(), allowCompressed); });
+    }
+    return image;
+}
+
+const MeshData& AssetLoader::getMesh(const char* path, unsigned int flags)
+{
+    requestMesh(path, flags);
+    return m_meshes[{ path, flags }].get();
+}
+
+const ImageData& AssetLoader::getImage(const char* path, bool allowCompressed)
+{
+    requestImage(path, allowCompressed);
+    return m_images[{ path, allowCompressed }].get();
+}
+
+void AssetLoader::release()
+{
+    m_meshes.clear();
+    m_images.clear();
+}
@@ -0,0 +1,38 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <future>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "model.h"
+#include "texture.h"
+#include "thread_pool.h"
+
+// Decodes images and loads meshes on worker threads. The GL thread requests
+// every asset up front, then gets them in the order it uploads them: the
+// wait is bounded by the slowest asset instead of the sum of all of them.
+class AssetLoader
+{
+public:
+    // Starts loading in the background, the same asset is loaded only once
+    void requestMesh(const char* path, unsigned int flags = 0);
+    std::shared_future<ImageData> requestImage(const char* path, bool allowCompressed = true);
+
+    // Wait for the asset, requesting it first if needed. The reference stays
+    // valid until release().
+    const MeshData& getMesh(const char* path, unsigned int flags = 0);
+    const ImageData& getImage(const char* path, bool allowCompressed = true);
+
+    // Drops the loader's references to the CPU copies once everything is
+    // uploaded. Loads still pending complete for whoever holds their future.
+    void release();
+
+private:
+    ThreadPool m_pool;
+    std::map<std::pair<std::string, unsigned int>, std::shared_future<MeshData>> m_meshes;
+    std::map<std::pair<std::string, bool>, std::shared_future<ImageData>> m_images;
+};
+
+#endif // ASSET_LOADER_H
@@ -0,0 +1,114 @@
+// Compares the streaming ObjParser with objl::Loader on .obj files.
+//
+// Usage (from src/): obj_bench.exe [file.obj ...]
+// Without arguments, every .obj in ../models is measured.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "obj_loader.h"
+#include "obj_parser.h"
+
+namespace
+{
+    // Same conversion as the former Model::loadObj
+    bool loadWithObjl(const char* path, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices)
+    {
+        objl::Loader loader;
+        if (!loader.LoadFile(path))
+            return false;
+
+        for (size_t i = 0; i < loader.LoadedVertices.size(); i++)
+        {
+            const objl::Vertex& v = loader.LoadedVertices[i];
+            vertexData.insert(vertexData.end(), {
+                v.Position.X, v.Position.Y, v.Position.Z,
+                v.TextureCoordinate.X, v.TextureCoordinate.Y,
+                v.Normal.X, v.Normal.Y, v.Normal.Z
+            });
+        }
+        indices = loader.LoadedIndices;
+        return true;
+    }
+
+    template<typename F>
+    double bestOf(int iterations, F&& f)
+    {
+        double best = 1e30;
+        for (int i = 0; i < iterations; ++i)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            f();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+        files.push_back(argv[i]);
+
+    if (files.empty())
+    {
+        for (const auto& entry : std::filesystem::directory_iterator("../models"))
+            if (entry.path().extension() == ".obj")
+                files.push_back(entry.path().string());
+        std::sort(files.begin(), files.end());
+    }
+
+    const int ITERATIONS = 10;
+    ObjParser parser;
+
+    std::cout << std::left << std::setw(28) << "file"
+              << std::right << std::setw(12) << "triangles"
+              << std::setw(14) << "objl (ms)"
+              << std::setw(14) << "parser (ms)"
+              << std::setw(10) << "speedup"
+              << "  output" << std::endl;
+
+    for (const std::string& file : files)
+    {
+        std::vector<GLfloat> objlVertices, parserVertices;
+        std::vector<GLuint> objlIndices, parserIndices;
+
+        double objlTime = bestOf(ITERATIONS, [&]()
+        {
+            objlVertices.clear();
+            objlIndices.clear();
+            loadWithObjl(file.c_str(), objlVertices, objlIndices);
+        });
+        double parserTime = bestOf(ITERATIONS, [&]()
+        {
+            parserVertices.clear();
+            parserIndices.clear();
+            parser.parseFile(file.c_str(), parserVertices, parserIndices);
+        });
+
+        // objl ear-clips polygons with more than four corners, the parser fans
+        // them, so only the vertex stream and triangle count must match exactly.
+        const char* status = "identical";
+        if (objlVertices != parserVertices || objlIndices.size() != parserIndices.size())
+            status = "MISMATCH";
+        else if (objlIndices != parserIndices)
+            status = "same vertices, other triangulation";
+
+        std::cout << std::left << std::setw(28) << std::filesystem::path(file).filename().string()
+                  << std::right << std::setw(12) << parserIndices.size() / 3
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << objlTime
+                  << std::setw(14) << parserTime
+                  << std::setprecision(1)
+                  << std::setw(9) << objlTime / parserTime << "x"
+                  << "  " << status << std::endl;
+    }
+    return 0;
+}
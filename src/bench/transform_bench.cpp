@@ -0,0 +1,130 @@
+// Compares TransformBatch with the per object glm computation it replaces.
+//
+// Usage (from src/): transform_bench.exe [object count ...]
+// Without arguments, 100, 1000, 10000 and 100000 objects are measured.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "transform_batch.h"
+
+namespace
+{
+    template<typename F>
+    double bestOf(int iterations, F&& f)
+    {
+        double best = 1e30;
+        for (int i = 0; i < iterations; ++i)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            f();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    // Rotation, non uniform scale and translation, like the scene props
+    glm::mat4 randomModel(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+
+        const float a = angle(rng), b = angle(rng);
+        const float ca = std::cos(a), sa = std::sin(a), cb = std::cos(b), sb = std::sin(b);
+        const float sx = scale(rng), sy = scale(rng), sz = scale(rng);
+        return glm::mat4(glm::vec4(ca * cb * sx, sa * cb * sx, -sb * sx, 0.0f),
+                         glm::vec4(-sa * sy, ca * sy, 0.0f, 0.0f),
+                         glm::vec4(ca * sb * sz, sa * sb * sz, cb * sz, 0.0f),
+                         glm::vec4(position(rng), position(rng), position(rng), 1.0f));
+    }
+
+    float maxDifference(const std::vector<ObjectData>& a, const std::vector<ObjectData>& b)
+    {
+        float difference = 0.0f;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            const float* x = &a[i].mvp[0][0];
+            const float* y = &b[i].mvp[0][0];
+            for (size_t j = 0; j < sizeof(ObjectData) / sizeof(float); ++j)
+                difference = std::max(difference, std::fabs(x[j] - y[j]) / std::max(1.0f, std::fabs(x[j])));
+        }
+        return difference;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; ++i)
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    if (counts.empty())
+        counts = { 100, 1000, 10000, 100000 };
+
+    const int ITERATIONS = 20;
+    const TransformBatch::Isa ISAS[] = { TransformBatch::ISA_SCALAR, TransformBatch::ISA_SSE, TransformBatch::ISA_AVX };
+    std::mt19937 rng(2705);
+
+    const glm::mat4 view = randomModel(rng);
+    glm::mat4 proj(0.0f);
+    proj[0][0] = 1.3f;
+    proj[1][1] = 1.7f;
+    proj[2][2] = -1.002f;
+    proj[2][3] = -1.0f;
+    proj[3][2] = -0.2f;
+    const glm::mat4 projView = proj * view;
+
+    std::cout << std::left << std::setw(10) << "objects"
+              << std::setw(8) << "isa"
+              << std::right << std::setw(12) << "glm (ms)"
+              << std::setw(14) << "batch (ms)"
+              << std::setw(10) << "speedup"
+              << std::setw(14) << "max error" << std::endl;
+
+    for (size_t count : counts)
+    {
+        std::vector<glm::mat4> models;
+        TransformBatch batch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            models.push_back(randomModel(rng));
+            batch.add(models.back());
+        }
+
+        std::vector<ObjectData> reference(count), result(count);
+        double glmTime = bestOf(ITERATIONS, [&]()
+        {
+            for (size_t i = 0; i < count; ++i)
+                reference[i] = computeObjectData(projView, view, models[i]);
+        });
+
+        for (TransformBatch::Isa isa : ISAS)
+        {
+            if (!TransformBatch::isSupported(isa))
+                continue;
+            double batchTime = bestOf(ITERATIONS, [&]()
+            {
+                batch.compute(projView, view, result.data(), isa);
+            });
+
+            std::cout << std::left << std::setw(10) << count
+                      << std::setw(8) << TransformBatch::getIsaName(isa)
+                      << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(12) << glmTime
+                      << std::setw(14) << batchTime
+                      << std::setprecision(1)
+                      << std::setw(9) << glmTime / batchTime << "x"
+                      << std::scientific << std::setprecision(1)
+                      << std::setw(14) << maxDifference(reference, result)
+                      << std::defaultfloat << std::endl;
+        }
+    }
+    return 0;
+}
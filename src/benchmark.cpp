@@ -0,0 +1,220 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "imgui/imgui.h"
+
+#include "gl_state.h"
+
+namespace
+{
+    const float TWO_PI = 6.28318530718f;
+
+    struct BenchmarkCase
+    {
+        const char* name;
+        Scene* scene;
+        std::function<void(float t)> setup; // t in [0, 1] along the path
+    };
+
+    struct Percentiles
+    {
+        double min, p50, p90, p95, p99, max, mean;
+    };
+
+    // Color and depth-stencil renderbuffers the size of the window
+    class OffscreenTarget
+    {
+    public:
+        OffscreenTarget(int width, int height)
+        {
+            glGenRenderbuffers(2, m_renderbuffers);
+            glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[0]);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[1]);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+            glGenFramebuffers(1, &m_fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_renderbuffers[0]);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_renderbuffers[1]);
+        }
+
+        ~OffscreenTarget()
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDeleteFramebuffers(1, &m_fbo);
+            glDeleteRenderbuffers(2, m_renderbuffers);
+        }
+
+        bool isComplete()
+        {
+            return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        }
+
+    private:
+        GLuint m_fbo;
+        GLuint m_renderbuffers[2];
+    };
+
+    Percentiles computePercentiles(std::vector<double> values)
+    {
+        Percentiles p = { 0, 0, 0, 0, 0, 0, 0 };
+        if (values.empty())
+            return p;
+
+        std::sort(values.begin(), values.end());
+        // Nearest rank
+        auto rank = [&values](double q) {
+            size_t i = size_t(std::ceil(q * values.size()));
+            return values[std::min(values.size(), std::max<size_t>(i, 1)) - 1];
+        };
+        p.min = values.front();
+        p.p50 = rank(0.50);
+        p.p90 = rank(0.90);
+        p.p95 = rank(0.95);
+        p.p99 = rank(0.99);
+        p.max = values.back();
+        for (double v : values)
+            p.mean += v;
+        p.mean /= values.size();
+        return p;
+    }
+
+    void writePercentiles(std::ostream& out, const char* name, const Percentiles& p)
+    {
+        out << "\"" << name << "\": { \"min\": " << p.min << ", \"p50\": " << p.p50 << ", \"p90\": " << p.p90
+            << ", \"p95\": " << p.p95 << ", \"p99\": " << p.p99 << ", \"max\": " << p.max
+            << ", \"mean\": " << p.mean << " }";
+    }
+
+    std::string escapeJson(const char* text)
+    {
+        std::string escaped;
+        for (const char* c = text; *c; c++)
+        {
+            if (*c == '"' || *c == '\\')
+                escaped += '\\';
+            escaped += *c;
+        }
+        return escaped;
+    }
+}
+
+int runBenchmark(Window& w, Resources& res, SceneStencil& stencil, SceneLighting& lighting,
+                 const BenchmarkOptions& options)
+{
+    OffscreenTarget target(w.getWidth(), w.getHeight());
+    if (!target.isComplete())
+    {
+        std::cout << "Benchmark: offscreen framebuffer is incomplete" << std::endl;
+        return -3;
+    }
+    glViewport(0, 0, w.getWidth(), w.getHeight());
+
+    // Every case measures the final textures
+    while (!res.textureStreamer.isIdle())
+    {
+        GLState::beginFrame();
+        res.textureStreamer.update();
+        std::this_thread::yield();
+    }
+
+    std::vector<BenchmarkCase> cases;
+    // Ellipse around the statues, the rock and the glass, looking at the center
+    cases.push_back({ "stencil", &stencil, [&stencil](float t) {
+        glm::vec3 position(18.0f * std::cos(TWO_PI * t), 2.0f, 10.0f * std::sin(TWO_PI * t));
+        stencil.setCamera(position, glm::vec2(-0.1f, std::atan2(position.x, position.z)));
+    }});
+    const char* shadingNames[] = { "lighting_flat", "lighting_gouraud", "lighting_phong", "lighting_deferred",
+                                   "lighting_clustered" };
+    for (int shading = 0; shading < 5; shading++)
+    {
+        // One turn around the object, bobbing up and down
+        cases.push_back({ shadingNames[shading], &lighting, [&lighting, shading](float t) {
+            lighting.setShading(shading);
+            lighting.setCamera(glm::vec2(0.3f + 0.2f * std::sin(2.0f * TWO_PI * t), TWO_PI * t));
+        }});
+    }
+
+    // Timestamps rather than a GL_TIME_ELAPSED query, the scenes' Profiler
+    // sections already use the only one allowed at a time
+    GLuint queries[2];
+    glGenQueries(2, queries);
+
+    std::ofstream out(options.outputPath);
+    if (!out)
+    {
+        std::cout << "Benchmark: unable to write " << options.outputPath << std::endl;
+        glDeleteQueries(2, queries);
+        return -4;
+    }
+    out << "{\n";
+    out << "  \"renderer\": \"" << escapeJson((const char*)glGetString(GL_RENDERER)) << "\",\n";
+    out << "  \"version\": \"" << escapeJson((const char*)glGetString(GL_VERSION)) << "\",\n";
+    out << "  \"width\": " << w.getWidth() << ", \"height\": " << w.getHeight() << ",\n";
+    out << "  \"frames\": " << options.frames << ",\n";
+    out << "  \"cases\": [\n";
+
+    for (size_t c = 0; c < cases.size(); c++)
+    {
+        const BenchmarkCase& benchCase = cases[c];
+        std::vector<double> frameTimes, gpuTimes;
+        frameTimes.reserve(options.frames);
+        gpuTimes.reserve(options.frames);
+
+        for (int frame = 0; frame < options.warmupFrames + options.frames; frame++)
+        {
+            const int measured = frame - options.warmupFrames;
+            benchCase.setup(measured < 0 ? 0.0f : float(measured) / options.frames);
+
+            GLState::beginFrame();
+            res.profiler.beginFrame();
+
+            // Each frame is finished before the next, so the time includes the GPU
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            glQueryCounter(queries[0], GL_TIMESTAMP);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            benchCase.scene->run(w, 0.0);
+            glQueryCounter(queries[1], GL_TIMESTAMP);
+            glFinish();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+            // Nothing is shown, the ImGui frame is only closed
+            ImGui::EndFrame();
+            w.pollEvent();
+
+            if (measured >= 0)
+            {
+                GLuint64 gpuStart = 0, gpuEnd = 0;
+                glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &gpuStart);
+                glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &gpuEnd);
+                frameTimes.push_back(elapsed.count());
+                gpuTimes.push_back((gpuEnd - gpuStart) / 1e6);
+            }
+        }
+
+        Percentiles frame = computePercentiles(frameTimes);
+        std::cout << benchCase.name << ": p50 " << frame.p50 << " ms, p99 " << frame.p99 << " ms" << std::endl;
+
+        out << "    { \"name\": \"" << benchCase.name << "\", ";
+        writePercentiles(out, "frame_ms", frame);
+        out << ", ";
+        writePercentiles(out, "gpu_ms", computePercentiles(gpuTimes));
+        out << " }" << (c + 1 < cases.size() ? "," : "") << "\n";
+    }
+
+    out << "  ]\n}\n";
+    glDeleteQueries(2, queries);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "resources.h"
+#include "window.h"
+
+#include "scenes/scene_stencil.h"
+#include "scenes/scene_lighting.h"
+
+struct BenchmarkOptions
+{
+    int frames;         // measured frames per case
+    int warmupFrames;
+    const char* outputPath;
+};
+
+// Replays a scripted camera path in each scene (and each shading mode of
+// SceneLighting) into an offscreen framebuffer, then writes frame time
+// percentiles as JSON. Returns the process exit code.
+int runBenchmark(Window& w, Resources& res, SceneStencil& stencil, SceneLighting& lighting,
+                 const BenchmarkOptions& options);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,35 @@
+#include "bindless_texture_table.h"
+
+#include <algorithm>
+
+bool BindlessTextureTable::isSupported()
+{
+    return GLEW_ARB_bindless_texture && GLEW_VERSION_4_3;
+}
+
+BindlessTextureTable::BindlessTextureTable()
+: m_dirty(true)
+{
+}
+
+GLuint BindlessTextureTable::add(Texture2D& texture)
+{
+    const GLuint64 handle = texture.getBindlessHandle();
+    std::vector<GLuint64>::iterator it = std::find(m_handles.begin(), m_handles.end(), handle);
+    if (it != m_handles.end())
+        return it - m_handles.begin();
+
+    m_handles.push_back(handle);
+    m_dirty = true;
+    return m_handles.size() - 1;
+}
+
+void BindlessTextureTable::bind(GLuint binding)
+{
+    if (m_dirty)
+    {
+        m_buffer.allocate(GL_SHADER_STORAGE_BUFFER, m_handles.size() * sizeof(GLuint64), m_handles.data(), GL_STATIC_DRAW);
+        m_dirty = false;
+    }
+    m_buffer.bindBase(binding);
+}
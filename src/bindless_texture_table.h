@@ -0,0 +1,36 @@
+#ifndef BINDLESS_TEXTURE_TABLE_H
+#define BINDLESS_TEXTURE_TABLE_H
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "buffer_object.h"
+#include "texture.h"
+
+// Bindless handles of Texture2Ds in a shader storage buffer, read by shaders
+// as `uvec2 textures[]` and turned into sampler2D with the index the draw
+// provides (the per-instance texture layer of DrawBatch). A single draw can
+// then sample any texture of the table without binding anything.
+class BindlessTextureTable
+{
+public:
+    // ARB_bindless_texture, and GL 4.3 for the shader storage buffer of the
+    // #version 430 shader
+    static bool isSupported();
+
+    BindlessTextureTable();
+
+    // Index of the texture's handle, the texture becomes immutable
+    GLuint add(Texture2D& texture);
+
+    // Uploads the table if it changed
+    void bind(GLuint binding);
+
+private:
+    std::vector<GLuint64> m_handles;
+    BufferObject m_buffer;
+    bool m_dirty;
+};
+
+#endif // BINDLESS_TEXTURE_TABLE_H
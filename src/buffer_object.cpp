@@ -0,0 +1,55 @@
+#include "buffer_object.h"
+
+#include "gl_state.h"
+
+BufferObject::BufferObject()
+: m_type(GL_ARRAY_BUFFER)
+{
+    glGenBuffers(1, &m_id);
+}
+
+BufferObject::BufferObject(GLenum type, GLsizeiptr dataSize, const void* data, GLenum usage)
+: BufferObject()
+{
+    allocate(type, dataSize, data, usage);
+}
+
+BufferObject::~BufferObject()
+{
+    GLState::deleteBuffer(m_id);
+}
+
+void BufferObject::bind()
+{
+    GLState::bindBuffer(m_type, m_id);
+}
+
+void BufferObject::bindBase(GLuint index)
+{
+    GLState::bindBufferBase(m_type, index, m_id);
+}
+
+void BufferObject::allocate(GLenum type, GLsizeiptr dataSize, const void* data, GLenum usage)
+{
+    m_type = type;
+    bind();
+    glBufferData(m_type, dataSize, data, usage);
+}
+
+void BufferObject::update(GLsizeiptr dataSize, const void* data)
+{
+    bind();
+    glBufferSubData(m_type, 0, dataSize, data);
+}
+
+void* BufferObject::mapBuffer()
+{
+    bind();
+    return glMapBuffer(m_type, GL_READ_WRITE);
+}
+
+void BufferObject::unmapBuffer()
+{
+    bind();
+    glUnmapBuffer(m_type);
+}
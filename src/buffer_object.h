@@ -11,6 +11,8 @@ public:
     ~BufferObject();
 
     void bind();
+    // Uniform or shader storage buffers, to a binding point of their type
+    void bindBase(GLuint index);
     
     void allocate(GLenum type, GLsizeiptr dataSize, const void* data, GLenum usage);
     
@@ -0,0 +1,285 @@
+#include "clustered_lights.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CLUSTERED_LIGHTS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // The froxel bounds are read 4 at a time from any tile of a row
+    const int BOUNDS_PADDING = 4;
+
+    void upload(BufferObject& buffer, GLsizeiptr& capacity, GLsizeiptr size, const void* data)
+    {
+        if (size > capacity)
+        {
+            buffer.allocate(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+            capacity = size;
+        }
+        else
+        {
+            buffer.update(size, data);
+        }
+    }
+}
+
+bool ClusteredLights::isSupported()
+{
+    return GLEW_VERSION_4_3;
+}
+
+ClusteredLights::ClusteredLights()
+: m_boundsProjection(0.0f)
+, m_near(0.1f)
+, m_far(100.0f)
+, m_clusters(CLUSTER_COUNT * 2, 0)
+, m_isLightBufferDirty(true)
+, m_lightCapacity(0)
+, m_clusterCapacity(0)
+, m_indexCapacity(0)
+, m_stats{}
+{
+}
+
+void ClusteredLights::setLightCount(size_t count)
+{
+    if (count == m_worldLights.size())
+        return;
+    m_worldLights.resize(count, WorldLight{});
+    m_isLightBufferDirty = true;
+}
+
+size_t ClusteredLights::getLightCount() const
+{
+    return m_worldLights.size();
+}
+
+void ClusteredLights::setLight(size_t index, const glm::vec3& position, GLfloat range, const glm::vec3& direction,
+                               const glm::vec3& diffuse, const glm::vec3& specular)
+{
+    const WorldLight light = { position, range, glm::normalize(direction), diffuse, specular };
+    if (std::memcmp(&light, &m_worldLights[index], sizeof(light)) == 0)
+        return;
+    m_worldLights[index] = light;
+    m_isLightBufferDirty = true;
+}
+
+void ClusteredLights::update(const glm::mat4& view, const glm::mat4& projection)
+{
+    if (projection != m_boundsProjection)
+        buildClusterBounds(projection);
+
+    m_pairClusters.clear();
+    m_pairLights.clear();
+    for (size_t i = 0; i < m_worldLights.size(); ++i)
+    {
+        const WorldLight& light = m_worldLights[i];
+        assign(i, glm::vec3(view * glm::vec4(light.position, 1.0f)), light.range, projection);
+    }
+
+    // Counting sort of the (froxel, light) pairs by froxel
+    for (int c = 0; c < CLUSTER_COUNT; ++c)
+        m_clusters[c * 2 + 1] = 0;
+    for (uint32_t cluster : m_pairClusters)
+        m_clusters[cluster * 2 + 1]++;
+    GLuint offset = 0;
+    m_stats.maxPerCluster = 0;
+    for (int c = 0; c < CLUSTER_COUNT; ++c)
+    {
+        m_clusters[c * 2] = offset;
+        offset += m_clusters[c * 2 + 1];
+        m_stats.maxPerCluster = std::max<int>(m_stats.maxPerCluster, m_clusters[c * 2 + 1]);
+        m_clusters[c * 2 + 1] = 0;
+    }
+    m_indices.resize(std::max<size_t>(m_pairLights.size(), 1));
+    for (size_t i = 0; i < m_pairClusters.size(); ++i)
+    {
+        GLuint* cluster = &m_clusters[m_pairClusters[i] * 2];
+        m_indices[cluster[0] + cluster[1]++] = m_pairLights[i];
+    }
+    m_stats.lights = m_worldLights.size();
+    m_stats.assignments = m_pairLights.size();
+
+    if (m_isLightBufferDirty)
+    {
+        m_lights.clear();
+        for (const WorldLight& light : m_worldLights)
+        {
+            m_lights.push_back({ glm::vec4(light.position, light.range), glm::vec4(light.diffuse, 0.0f),
+                                 glm::vec4(light.specular, 0.0f), glm::vec4(light.direction, 0.0f) });
+        }
+        if (m_lights.empty())
+            m_lights.push_back(ClusterLight{});
+        upload(m_lightBuffer, m_lightCapacity, m_lights.size() * sizeof(ClusterLight), m_lights.data());
+        m_isLightBufferDirty = false;
+    }
+    upload(m_clusterBuffer, m_clusterCapacity, m_clusters.size() * sizeof(GLuint), m_clusters.data());
+    upload(m_indexBuffer, m_indexCapacity, m_indices.size() * sizeof(GLuint), m_indices.data());
+}
+
+void ClusteredLights::bind(GLuint lightBinding, GLuint clusterBinding, GLuint indexBinding)
+{
+    m_lightBuffer.bindBase(lightBinding);
+    m_clusterBuffer.bindBase(clusterBinding);
+    m_indexBuffer.bindBase(indexBinding);
+}
+
+GLfloat ClusteredLights::getDepthSliceScale() const
+{
+    return GRID_Z / std::log(m_far / m_near);
+}
+
+GLfloat ClusteredLights::getDepthSliceBias() const
+{
+    return -GRID_Z * std::log(m_near) / std::log(m_far / m_near);
+}
+
+const ClusteredLights::Stats& ClusteredLights::getStats() const
+{
+    return m_stats;
+}
+
+void ClusteredLights::buildClusterBounds(const glm::mat4& projection)
+{
+    m_boundsProjection = projection;
+    m_near = projection[3][2] / (projection[2][2] - 1.0f);
+    m_far = projection[3][2] / (projection[2][2] + 1.0f);
+
+    for (std::vector<float>* bounds : { &m_minX, &m_minY, &m_minZ, &m_maxX, &m_maxY, &m_maxZ })
+        bounds->assign(CLUSTER_COUNT + BOUNDS_PADDING, 0.0f);
+
+    // A point at view depth d seen at ndc: d * (ndc + projection[2]) / projection diagonal
+    for (int z = 0; z < GRID_Z; ++z)
+    {
+        const float depths[2] = { m_near * std::pow(m_far / m_near, float(z) / GRID_Z),
+                                  m_near * std::pow(m_far / m_near, float(z + 1) / GRID_Z) };
+        for (int y = 0; y < GRID_Y; ++y)
+        {
+            for (int x = 0; x < GRID_X; ++x)
+            {
+                glm::vec3 boundsMin(INFINITY), boundsMax(-INFINITY);
+                for (float depth : depths)
+                {
+                    for (int corner = 0; corner < 4; ++corner)
+                    {
+                        const float ndcX = float(x + (corner & 1)) / GRID_X * 2.0f - 1.0f;
+                        const float ndcY = float(y + (corner >> 1)) / GRID_Y * 2.0f - 1.0f;
+                        const glm::vec3 point(depth * (ndcX + projection[2][0]) / projection[0][0],
+                                              depth * (ndcY + projection[2][1]) / projection[1][1],
+                                              -depth);
+                        boundsMin = glm::min(boundsMin, point);
+                        boundsMax = glm::max(boundsMax, point);
+                    }
+                }
+                const int cluster = (z * GRID_Y + y) * GRID_X + x;
+                m_minX[cluster] = boundsMin.x;
+                m_minY[cluster] = boundsMin.y;
+                m_minZ[cluster] = boundsMin.z;
+                m_maxX[cluster] = boundsMax.x;
+                m_maxY[cluster] = boundsMax.y;
+                m_maxZ[cluster] = boundsMax.z;
+            }
+        }
+    }
+}
+
+void ClusteredLights::assign(uint32_t light, const glm::vec3& center, float radius, const glm::mat4& projection)
+{
+    if (radius <= 0.0f)
+    {
+        for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster)
+        {
+            m_pairClusters.push_back(cluster);
+            m_pairLights.push_back(light);
+        }
+        return;
+    }
+
+    // Slices, then tiles of the screen rectangle around the sphere
+    const float depthMin = -center.z - radius;
+    const float depthMax = -center.z + radius;
+    if (depthMax < m_near || depthMin > m_far)
+        return;
+    const float scale = getDepthSliceScale(), bias = getDepthSliceBias();
+    const int zMin = std::max(0, int(std::log(std::max(depthMin, m_near)) * scale + bias));
+    const int zMax = std::min(GRID_Z - 1, int(std::log(std::min(depthMax, m_far)) * scale + bias));
+
+    int xMin = 0, xMax = GRID_X - 1, yMin = 0, yMax = GRID_Y - 1;
+    if (depthMin > m_near)
+    {
+        // Projection of the corners of the sphere's box
+        glm::vec2 ndcMin(INFINITY), ndcMax(-INFINITY);
+        for (float depth : { depthMin, depthMax })
+        {
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                const float x = center.x + ((corner & 1) ? radius : -radius);
+                const float y = center.y + ((corner >> 1) ? radius : -radius);
+                const glm::vec2 ndc(x * projection[0][0] / depth - projection[2][0],
+                                    y * projection[1][1] / depth - projection[2][1]);
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+        }
+        if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+            return;
+        xMin = std::max(xMin, int((ndcMin.x + 1.0f) * 0.5f * GRID_X));
+        xMax = std::min(xMax, int((ndcMax.x + 1.0f) * 0.5f * GRID_X));
+        yMin = std::max(yMin, int((ndcMin.y + 1.0f) * 0.5f * GRID_Y));
+        yMax = std::min(yMax, int((ndcMax.y + 1.0f) * 0.5f * GRID_Y));
+    }
+
+    // Sphere against the froxel boxes
+    const float radius2 = radius * radius;
+    for (int z = zMin; z <= zMax; ++z)
+    {
+        for (int y = yMin; y <= yMax; ++y)
+        {
+            const int row = (z * GRID_Y + y) * GRID_X;
+            int x = xMin;
+#ifdef CLUSTERED_LIGHTS_SSE
+            const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+            const __m128 r2 = _mm_set1_ps(radius2);
+            const __m128 zero = _mm_setzero_ps();
+            for (; x <= xMax; x += 4)
+            {
+                const int i = row + x;
+                const __m128 dx = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minX[i]), cx),
+                                                              _mm_sub_ps(cx, _mm_loadu_ps(&m_maxX[i]))));
+                const __m128 dy = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minY[i]), cy),
+                                                              _mm_sub_ps(cy, _mm_loadu_ps(&m_maxY[i]))));
+                const __m128 dz = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minZ[i]), cz),
+                                                              _mm_sub_ps(cz, _mm_loadu_ps(&m_maxZ[i]))));
+                const __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                                    _mm_mul_ps(dz, dz));
+                const int mask = _mm_movemask_ps(_mm_cmple_ps(distance2, r2));
+                for (int k = 0; k < 4 && x + k <= xMax; ++k)
+                {
+                    if (mask & (1 << k))
+                    {
+                        m_pairClusters.push_back(i + k);
+                        m_pairLights.push_back(light);
+                    }
+                }
+            }
+#endif
+            for (; x <= xMax; ++x)
+            {
+                const int i = row + x;
+                const float dx = std::max(0.0f, std::max(m_minX[i] - center.x, center.x - m_maxX[i]));
+                const float dy = std::max(0.0f, std::max(m_minY[i] - center.y, center.y - m_maxY[i]));
+                const float dz = std::max(0.0f, std::max(m_minZ[i] - center.z, center.z - m_maxZ[i]));
+                if (dx * dx + dy * dy + dz * dz <= radius2)
+                {
+                    m_pairClusters.push_back(i);
+                    m_pairLights.push_back(light);
+                }
+            }
+        }
+    }
+}
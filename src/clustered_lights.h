@@ -0,0 +1,105 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "buffer_object.h"
+
+// std430 layout of a light in LightBuffer, in world space
+struct ClusterLight
+{
+    glm::vec4 positionRange; // w: range, 0 for a light reaching everything
+    glm::vec4 diffuse;       // vec3, but padded
+    glm::vec4 specular;      // vec3, but padded
+    glm::vec4 direction;     // spot direction, vec3, but padded
+};
+
+// Clustered forward shading: the view frustum is split in GRID_X x GRID_Y
+// screen tiles and GRID_Z exponential depth slices (froxels), and update()
+// lists the lights whose sphere touches each froxel, 4 froxels per test
+// (SSE). A fragment then only loops over the lights of its own froxel.
+// The lights themselves are only uploaded when one of them changes, the
+// froxel lists follow the camera and are rebuilt every update().
+// Three shader storage buffers, read by a #version 430 shader, so GL 4.3:
+//  - LightBuffer: ClusterLight[]
+//  - ClusterBuffer: uvec2[] offset and count in LightIndexBuffer, per froxel,
+//    x first, then y, then the slice
+//  - LightIndexBuffer: uint[]
+class ClusteredLights
+{
+public:
+    static const int GRID_X = 16;
+    static const int GRID_Y = 9;
+    static const int GRID_Z = 24;
+    static const int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    struct Stats
+    {
+        int lights;
+        int assignments;
+        int maxPerCluster;
+    };
+
+public:
+    static bool isSupported();
+
+    ClusteredLights();
+
+    void setLightCount(size_t count);
+    size_t getLightCount() const;
+    // World space, range 0 for a light reaching everything
+    void setLight(size_t index, const glm::vec3& position, GLfloat range, const glm::vec3& direction,
+                  const glm::vec3& diffuse, const glm::vec3& specular);
+
+    // Bins the lights in the froxels of a perspective projection and uploads
+    // the lists, and the lights if they changed
+    void update(const glm::mat4& view, const glm::mat4& projection);
+    void bind(GLuint lightBinding, GLuint clusterBinding, GLuint indexBinding);
+
+    // Slice of a view depth d: int(log(d) * scale + bias)
+    GLfloat getDepthSliceScale() const;
+    GLfloat getDepthSliceBias() const;
+
+    const Stats& getStats() const;
+
+private:
+    void buildClusterBounds(const glm::mat4& projection);
+    void assign(uint32_t light, const glm::vec3& center, float radius, const glm::mat4& projection);
+
+private:
+    struct WorldLight
+    {
+        glm::vec3 position;
+        GLfloat range;
+        glm::vec3 direction;
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+    };
+    std::vector<WorldLight> m_worldLights;
+
+    // View space bounds of every froxel, same order as ClusterBuffer
+    glm::mat4 m_boundsProjection;
+    float m_near, m_far;
+    std::vector<float> m_minX, m_minY, m_minZ;
+    std::vector<float> m_maxX, m_maxY, m_maxZ;
+
+    std::vector<ClusterLight> m_lights;
+    std::vector<uint32_t> m_pairClusters, m_pairLights;
+    std::vector<GLuint> m_clusters; // offset, count
+    std::vector<GLuint> m_indices;
+    bool m_isLightBufferDirty;
+
+    BufferObject m_lightBuffer;
+    BufferObject m_clusterBuffer;
+    BufferObject m_indexBuffer;
+    // Allocated on the first update(), only once shader storage is known to exist
+    GLsizeiptr m_lightCapacity, m_clusterCapacity, m_indexCapacity;
+
+    Stats m_stats;
+};
+
+#endif // CLUSTERED_LIGHTS_H
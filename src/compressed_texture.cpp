@@ -0,0 +1,232 @@
+#include "compressed_texture.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "mapped_file.h"
+
+namespace
+{
+    const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const uint32_t KTX_ENDIANNESS = 0x04030201;
+    const size_t KTX_HEADER_SIZE = 64;
+
+    const size_t DDS_HEADER_SIZE = 128; // magic included
+    const size_t DDS_DX10_HEADER_SIZE = 20;
+    const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+    const uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+    const uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+    const uint32_t DXGI_FORMAT_BC4_UNORM = 80;
+    const uint32_t DXGI_FORMAT_BC5_UNORM = 83;
+    const uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+
+    inline uint32_t readU32(const char* p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t fourCC(const char* code)
+    {
+        return readU32(code);
+    }
+
+    int channelCount(GLenum format)
+    {
+        switch (format)
+        {
+        case GL_COMPRESSED_RED_RGTC1: return 1;
+        case GL_COMPRESSED_RG_RGTC2: return 2;
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return 3;
+        default: return 4;
+        }
+    }
+
+    size_t levelSize(GLenum format, int width, int height)
+    {
+        return size_t((width + 3) / 4) * ((height + 3) / 4) * compressedBlockSize(format);
+    }
+
+    GLenum formatFromFourCC(uint32_t code)
+    {
+        if (code == fourCC("DXT1")) return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        if (code == fourCC("DXT5")) return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        if (code == fourCC("ATI1") || code == fourCC("BC4U")) return GL_COMPRESSED_RED_RGTC1;
+        if (code == fourCC("ATI2") || code == fourCC("BC5U")) return GL_COMPRESSED_RG_RGTC2;
+        return 0;
+    }
+
+    GLenum formatFromDxgi(uint32_t dxgiFormat)
+    {
+        switch (dxgiFormat)
+        {
+        case DXGI_FORMAT_BC1_UNORM: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case DXGI_FORMAT_BC3_UNORM: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case DXGI_FORMAT_BC4_UNORM: return GL_COMPRESSED_RED_RGTC1;
+        case DXGI_FORMAT_BC5_UNORM: return GL_COMPRESSED_RG_RGTC2;
+        case DXGI_FORMAT_BC7_UNORM: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        default: return 0;
+        }
+    }
+
+    // Offsets in image.levels are relative to the first level
+    bool parseKtx(const char* data, size_t size, ImageData& image, size_t& dataOffset)
+    {
+        if (size < KTX_HEADER_SIZE || readU32(data + 12) != KTX_ENDIANNESS)
+            return false;
+
+        const uint32_t glType = readU32(data + 16);
+        const GLenum format = readU32(data + 28);
+        image.width = readU32(data + 36);
+        image.height = readU32(data + 40);
+        const uint32_t depth = readU32(data + 44);
+        const uint32_t arrayElements = readU32(data + 48);
+        const uint32_t faces = readU32(data + 52);
+        const uint32_t levelCount = std::max(1u, readU32(data + 56));
+        const uint32_t keyValueBytes = readU32(data + 60);
+        if (glType != 0 || depth != 0 || arrayElements != 0 || faces != 1 || compressedBlockSize(format) == 0)
+            return false;
+
+        image.compressedFormat = format;
+        dataOffset = KTX_HEADER_SIZE + keyValueBytes + 4;
+        size_t offset = KTX_HEADER_SIZE + keyValueBytes;
+        int width = image.width, height = image.height;
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            if (offset + 4 > size)
+                return false;
+            const size_t imageSize = readU32(data + offset);
+            offset += 4;
+            if (imageSize != levelSize(format, width, height) || offset + imageSize > size)
+                return false;
+            image.levels.push_back({ offset - dataOffset, imageSize });
+            offset += (imageSize + 3) & ~size_t(3);
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return true;
+    }
+
+    bool parseDds(const char* data, size_t size, ImageData& image, size_t& dataOffset)
+    {
+        if (size < DDS_HEADER_SIZE || readU32(data + 4) != 124)
+            return false;
+
+        const uint32_t flags = readU32(data + 8);
+        image.height = readU32(data + 12);
+        image.width = readU32(data + 16);
+        const uint32_t levelCount = (flags & DDSD_MIPMAPCOUNT) ? std::max(1u, readU32(data + 28)) : 1;
+        const uint32_t pixelFormatFlags = readU32(data + 80);
+        const uint32_t code = readU32(data + 84);
+        if (!(pixelFormatFlags & DDPF_FOURCC))
+            return false;
+
+        dataOffset = DDS_HEADER_SIZE;
+        if (code == fourCC("DX10"))
+        {
+            if (size < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE)
+                return false;
+            const char* dx10 = data + DDS_HEADER_SIZE;
+            if (readU32(dx10 + 4) != DDS_DIMENSION_TEXTURE2D || readU32(dx10 + 12) > 1)
+                return false;
+            image.compressedFormat = formatFromDxgi(readU32(dx10));
+            dataOffset += DDS_DX10_HEADER_SIZE;
+        }
+        else
+        {
+            image.compressedFormat = formatFromFourCC(code);
+        }
+        if (image.compressedFormat == 0)
+            return false;
+
+        size_t offset = 0;
+        int width = image.width, height = image.height;
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            const size_t imageSize = levelSize(image.compressedFormat, width, height);
+            if (dataOffset + offset + imageSize > size)
+                return false;
+            image.levels.push_back({ offset, imageSize });
+            offset += imageSize;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return true;
+    }
+}
+
+bool loadCompressedImage(const char* path, ImageData& image)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+    if (!file->isOpen())
+        return false;
+
+    ImageData parsed = { 0, 0, 0, nullptr, 0, {} };
+    size_t dataOffset = 0;
+    const char* data = file->data();
+    const size_t size = file->size();
+    bool valid = false;
+    if (size >= sizeof(KTX_IDENTIFIER) && std::memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0)
+        valid = parseKtx(data, size, parsed, dataOffset);
+    else if (size >= 4 && std::memcmp(data, "DDS ", 4) == 0)
+        valid = parseDds(data, size, parsed, dataOffset);
+
+    if (!valid || parsed.width <= 0 || parsed.height <= 0)
+    {
+        std::cout << "Unsupported compressed texture \"" << path << "\"" << std::endl;
+        return false;
+    }
+    if (!isCompressedFormatSupported(parsed.compressedFormat))
+    {
+        std::cout << "Compressed format of \"" << path << "\" isn't supported by the driver" << std::endl;
+        return false;
+    }
+
+    // The image keeps the mapping alive
+    parsed.nChannels = channelCount(parsed.compressedFormat);
+    parsed.pixels = std::shared_ptr<unsigned char>(file, reinterpret_cast<unsigned char*>(const_cast<char*>(data + dataOffset)));
+    image = std::move(parsed);
+    return true;
+}
+
+bool isCompressedFormatSupported(GLenum format)
+{
+    switch (format)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return GLEW_EXT_texture_compression_s3tc;
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_RG_RGTC2:
+        return true; // core since 3.0
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+    default:
+        return false;
+    }
+}
+
+size_t compressedBlockSize(GLenum format)
+{
+    switch (format)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+        return 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        return 16;
+    default:
+        return 0;
+    }
+}
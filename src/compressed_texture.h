@@ -0,0 +1,23 @@
+#ifndef COMPRESSED_TEXTURE_H
+#define COMPRESSED_TEXTURE_H
+
+#include <cstddef>
+
+#include <GL/glew.h>
+
+#include "texture.h"
+
+// Block compressed textures (BC1, BC3, BC4, BC5, BC7) in KTX 1 or DDS
+// (including the DX10 header) containers. Images must be stored bottom row
+// first, as GL expects; tools/texture_compress writes them that way.
+
+// Maps the file, image.pixels points into it. Quiet if the file doesn't
+// exist, reports files it can't use.
+bool loadCompressedImage(const char* path, ImageData& image);
+
+bool isCompressedFormatSupported(GLenum format);
+
+// Bytes per 4x4 block, 0 for formats not listed above
+size_t compressedBlockSize(GLenum format);
+
+#endif // COMPRESSED_TEXTURE_H
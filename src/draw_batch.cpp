@@ -0,0 +1,114 @@
+#include "draw_batch.h"
+
+DrawBatch::DrawBatch(GeometryPool& pool)
+: m_pool(pool)
+, m_instanceCapacity(0)
+, m_dirty(false)
+, m_drawcall(pool.getVao(), GL_UNSIGNED_INT)
+{
+}
+
+void DrawBatch::clear()
+{
+    m_instances.clear();
+    m_drawcall.clear();
+    m_dirty = true;
+}
+
+void DrawBatch::add(const Model& model, const glm::mat4& transform, GLfloat textureLayer, int lod)
+{
+    add(model, &transform, 1, textureLayer, lod);
+}
+
+void DrawBatch::add(const Model& model, const glm::mat4* transforms, GLsizei count, GLfloat textureLayer, int lod)
+{
+    const MeshRange& range = model.getRange(lod);
+    if (range.indexCount == 0 || count == 0)
+        return;
+
+    const std::vector<DrawElementsIndirectCommand>& commands = m_drawcall.getCommands();
+    if (!commands.empty() && commands.back().firstIndex == range.firstIndex && commands.back().count == GLuint(range.indexCount)
+        && commands.back().baseVertex == range.baseVertex
+        && commands.back().baseInstance + commands.back().instanceCount == m_instances.size())
+    {
+        m_drawcall.addInstances(count);
+    }
+    else
+    {
+        DrawElementsIndirectCommand command;
+        command.count = range.indexCount;
+        command.instanceCount = count;
+        command.firstIndex = range.firstIndex;
+        command.baseVertex = range.baseVertex;
+        command.baseInstance = m_instances.size();
+        m_drawcall.addCommand(command);
+    }
+
+    for (GLsizei i = 0; i < count; i++)
+        m_instances.push_back({ transforms[i] * model.getVertexTransform(), textureLayer, { 0.0f, 0.0f, 0.0f } });
+    m_dirty = true;
+}
+
+void DrawBatch::add(const Model& model, const glm::mat4& transform, const std::vector<MeshRange>& ranges,
+                    GLfloat textureLayer)
+{
+    if (ranges.empty())
+        return;
+
+    for (const MeshRange& range : ranges)
+    {
+        DrawElementsIndirectCommand command;
+        command.count = range.indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = range.firstIndex;
+        command.baseVertex = range.baseVertex;
+        command.baseInstance = m_instances.size();
+        m_drawcall.addCommand(command);
+    }
+
+    m_instances.push_back({ transform * model.getVertexTransform(), textureLayer, { 0.0f, 0.0f, 0.0f } });
+    m_dirty = true;
+}
+
+void DrawBatch::draw()
+{
+    if (m_instances.empty())
+        return;
+
+    if (m_dirty)
+    {
+        const GLsizeiptr size = m_instances.size() * sizeof(InstanceData);
+        if (GLsizei(m_instances.size()) > m_instanceCapacity)
+        {
+            m_instanceBuffer.allocate(GL_ARRAY_BUFFER, size, m_instances.data(), GL_DYNAMIC_DRAW);
+            m_instanceCapacity = m_instances.size();
+        }
+        else
+        {
+            m_instanceBuffer.update(size, m_instances.data());
+        }
+        m_dirty = false;
+    }
+
+    if (MultiDrawElementsIndirectCommand::isBaseInstanceSupported())
+    {
+        m_pool.setInstanceBuffer(m_instanceBuffer, 0);
+        m_drawcall.draw();
+        return;
+    }
+
+    // GL 4.0/4.1: no baseInstance, the attributes are moved to each command's
+    // instances instead
+    for (const DrawElementsIndirectCommand& c : m_drawcall.getCommands())
+    {
+        m_pool.setInstanceBuffer(m_instanceBuffer, c.baseInstance);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, c.count, GL_UNSIGNED_INT,
+                                          (const void*)(c.firstIndex * sizeof(GLuint)),
+                                          c.instanceCount, c.baseVertex);
+    }
+}
+
+GeometryPool& DrawBatch::getPool() const
+{
+    return m_pool;
+}
@@ -0,0 +1,45 @@
+#ifndef DRAW_BATCH_H
+#define DRAW_BATCH_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "buffer_object.h"
+#include "draw_commands.h"
+#include "geometry_pool.h"
+#include "model.h"
+
+// Models of one GeometryPool drawn with the same state, each with one or more
+// model matrices, submitted as a single multi draw indirect. Shaders read the
+// matrix as a mat4 attribute at GeometryPool::INSTANCE_LOCATION and the
+// texture layer at GeometryPool::INSTANCE_LAYER_LOCATION.
+class DrawBatch
+{
+public:
+    DrawBatch(GeometryPool& pool);
+
+    void clear();
+    // Plain model matrices, the model's vertex transform is applied here.
+    // Adding the model and lod of the previous add() extends its instance count.
+    void add(const Model& model, const glm::mat4& transform, GLfloat textureLayer = 0.0f, int lod = 0);
+    void add(const Model& model, const glm::mat4* transforms, GLsizei count, GLfloat textureLayer = 0.0f, int lod = 0);
+    // One instance drawn over parts of the model's index buffer, one command
+    // per range (see MeshletCuller)
+    void add(const Model& model, const glm::mat4& transform, const std::vector<MeshRange>& ranges,
+             GLfloat textureLayer = 0.0f);
+
+    void draw();
+
+    GeometryPool& getPool() const;
+
+private:
+    GeometryPool& m_pool;
+    std::vector<InstanceData> m_instances;
+    BufferObject m_instanceBuffer;
+    GLsizei m_instanceCapacity;
+    bool m_dirty;
+    MultiDrawElementsIndirectCommand m_drawcall;
+};
+
+#endif // DRAW_BATCH_H
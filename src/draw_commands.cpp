@@ -0,0 +1,142 @@
+#include "draw_commands.h"
+
+namespace
+{
+    GLsizeiptr indexSize(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_UNSIGNED_BYTE: return sizeof(GLubyte);
+        case GL_UNSIGNED_SHORT: return sizeof(GLushort);
+        default: return sizeof(GLuint);
+        }
+    }
+}
+
+DrawArraysCommand::DrawArraysCommand(VertexArrayObject& vao, GLsizei count)
+: m_vao(vao)
+, m_count(count)
+{
+}
+
+void DrawArraysCommand::draw()
+{
+    m_vao.bind();
+    glDrawArrays(GL_TRIANGLES, 0, m_count);
+}
+
+void DrawArraysCommand::setCount(GLsizei count)
+{
+    m_count = count;
+}
+
+
+DrawElementsCommand::DrawElementsCommand(VertexArrayObject& vao, GLsizei count, GLenum type)
+: m_vao(vao)
+, m_count(count)
+, m_type(type)
+, m_firstIndex(0)
+, m_baseVertex(0)
+{
+}
+
+void DrawElementsCommand::draw()
+{
+    m_vao.bind();
+    const void* offset = (const void*)(m_firstIndex * indexSize(m_type));
+    if (m_baseVertex == 0)
+        glDrawElements(GL_TRIANGLES, m_count, m_type, offset);
+    else
+        glDrawElementsBaseVertex(GL_TRIANGLES, m_count, m_type, offset, m_baseVertex);
+}
+
+void DrawElementsCommand::drawInstanced(GLsizei instanceCount)
+{
+    m_vao.bind();
+    const void* offset = (const void*)(m_firstIndex * indexSize(m_type));
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, m_count, m_type, offset, instanceCount, m_baseVertex);
+}
+
+void DrawElementsCommand::setCount(GLsizei count)
+{
+    m_count = count;
+}
+
+void DrawElementsCommand::setRange(GLuint firstIndex, GLint baseVertex)
+{
+    m_firstIndex = firstIndex;
+    m_baseVertex = baseVertex;
+}
+
+
+MultiDrawElementsIndirectCommand::MultiDrawElementsIndirectCommand(VertexArrayObject& vao, GLenum type)
+: m_vao(vao)
+, m_type(type)
+, m_capacity(0)
+, m_dirty(false)
+{
+}
+
+void MultiDrawElementsIndirectCommand::draw()
+{
+    if (m_commands.empty())
+        return;
+
+    m_vao.bind();
+    if (!isMultiDrawSupported())
+    {
+        for (const DrawElementsIndirectCommand& c : m_commands)
+            glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, c.count, m_type,
+                                                          (const void*)(c.firstIndex * indexSize(m_type)),
+                                                          c.instanceCount, c.baseVertex, c.baseInstance);
+        return;
+    }
+
+    const GLsizeiptr size = m_commands.size() * sizeof(DrawElementsIndirectCommand);
+    if (GLsizei(m_commands.size()) > m_capacity)
+    {
+        m_buffer.allocate(GL_DRAW_INDIRECT_BUFFER, size, m_commands.data(), GL_DYNAMIC_DRAW);
+        m_capacity = m_commands.size();
+    }
+    else if (m_dirty)
+    {
+        m_buffer.update(size, m_commands.data());
+    }
+    m_dirty = false;
+
+    m_buffer.bind();
+    glMultiDrawElementsIndirect(GL_TRIANGLES, m_type, nullptr, m_commands.size(), 0);
+}
+
+void MultiDrawElementsIndirectCommand::clear()
+{
+    m_commands.clear();
+    m_dirty = true;
+}
+
+void MultiDrawElementsIndirectCommand::addCommand(const DrawElementsIndirectCommand& command)
+{
+    m_commands.push_back(command);
+    m_dirty = true;
+}
+
+void MultiDrawElementsIndirectCommand::addInstances(GLuint count)
+{
+    m_commands.back().instanceCount += count;
+    m_dirty = true;
+}
+
+const std::vector<DrawElementsIndirectCommand>& MultiDrawElementsIndirectCommand::getCommands() const
+{
+    return m_commands;
+}
+
+bool MultiDrawElementsIndirectCommand::isMultiDrawSupported()
+{
+    return GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+}
+
+bool MultiDrawElementsIndirectCommand::isBaseInstanceSupported()
+{
+    return GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+}
@@ -1,8 +1,11 @@
 #ifndef DRAW_COMMANDS_H
 #define DRAW_COMMANDS_H
 
+#include <vector>
+
 #include <GL/glew.h>
 
+#include "buffer_object.h"
 #include "vertex_array_object.h"
 
 class DrawArraysCommand
@@ -23,12 +26,57 @@ class DrawElementsCommand
 public:
     DrawElementsCommand(VertexArrayObject& vao, GLsizei count, GLenum type = GL_UNSIGNED_BYTE);
     void draw();
+    void drawInstanced(GLsizei instanceCount);
     
     void setCount(GLsizei count);
+    // Draws count indices from firstIndex, added to baseVertex
+    void setRange(GLuint firstIndex, GLint baseVertex);
 private:
     VertexArrayObject& m_vao;
     GLsizei m_count;
     GLenum m_type;
+    GLuint m_firstIndex;
+    GLint m_baseVertex;
+};
+
+
+// Layout read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Indexed draws sharing a VAO, submitted with one glMultiDrawElementsIndirect.
+// The command buffer is filled on the CPU and uploaded on the next draw after
+// a change.
+class MultiDrawElementsIndirectCommand
+{
+public:
+    MultiDrawElementsIndirectCommand(VertexArrayObject& vao, GLenum type = GL_UNSIGNED_INT);
+    void draw();
+
+    void clear();
+    void addCommand(const DrawElementsIndirectCommand& command);
+    // Adds instances to the last command
+    void addInstances(GLuint count);
+    const std::vector<DrawElementsIndirectCommand>& getCommands() const;
+
+    // GL 4.3, otherwise draw() issues one call per command
+    static bool isMultiDrawSupported();
+    // GL 4.2, required by draw() when commands use baseInstance
+    static bool isBaseInstanceSupported();
+
+private:
+    VertexArrayObject& m_vao;
+    GLenum m_type;
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    BufferObject m_buffer;
+    GLsizei m_capacity;
+    bool m_dirty;
 };
 
 #endif // DRAW_COMMANDS_H
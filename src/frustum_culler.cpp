@@ -0,0 +1,158 @@
+#include "frustum_culler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define FRUSTUM_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+FrustumCuller::FrustumCuller()
+: m_stats{}
+{
+    begin(glm::mat4(1.0f));
+}
+
+void FrustumCuller::begin(const glm::mat4& projView)
+{
+    // Gribb-Hartmann: the planes are the 4th row plus or minus the others
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; ++r)
+        rows[r] = glm::vec4(projView[0][r], projView[1][r], projView[2][r], projView[3][r]);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        m_planes[i * 2] = rows[3] + rows[i];
+        m_planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+    for (glm::vec4& plane : m_planes)
+    {
+        const float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+            plane = plane / length;
+    }
+
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_extentX.clear();
+    m_extentY.clear();
+    m_extentZ.clear();
+    m_radius.clear();
+    m_visible.clear();
+}
+
+size_t FrustumCuller::add(const Model& model, const glm::mat4& transform)
+{
+    const glm::vec3 center = model.getBoundingCenter();
+    const glm::vec3 halfExtent = (model.getBoundsMax() - model.getBoundsMin()) * 0.5f;
+
+    const glm::vec4 worldCenter = transform * glm::vec4(center, 1.0f);
+    m_centerX.push_back(worldCenter.x);
+    m_centerY.push_back(worldCenter.y);
+    m_centerZ.push_back(worldCenter.z);
+
+    // Box around the transformed box, and sphere scaled by the largest axis
+    float scale2 = 0.0f;
+    float extent[3] = { 0.0f, 0.0f, 0.0f };
+    for (int c = 0; c < 3; ++c)
+    {
+        const glm::vec3 axis(transform[c]);
+        scale2 = std::max(scale2, glm::dot(axis, axis));
+        for (int r = 0; r < 3; ++r)
+            extent[r] += std::fabs(axis[r]) * halfExtent[c];
+    }
+    m_extentX.push_back(extent[0]);
+    m_extentY.push_back(extent[1]);
+    m_extentZ.push_back(extent[2]);
+    m_radius.push_back(model.getBoundingRadius() * std::sqrt(scale2));
+
+    m_visible.push_back(true);
+    return m_visible.size() - 1;
+}
+
+void FrustumCuller::cull()
+{
+    const size_t count = m_visible.size();
+    size_t i = 0;
+
+#ifdef FRUSTUM_CULLER_SSE
+    __m128 planes[6][4];
+    __m128 absNormals[6][3];
+    for (int p = 0; p < 6; ++p)
+    {
+        for (int k = 0; k < 4; ++k)
+            planes[p][k] = _mm_set1_ps(m_planes[p][k]);
+        for (int k = 0; k < 3; ++k)
+            absNormals[p][k] = _mm_set1_ps(std::fabs(m_planes[p][k]));
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 cx = _mm_loadu_ps(&m_centerX[i]);
+        const __m128 cy = _mm_loadu_ps(&m_centerY[i]);
+        const __m128 cz = _mm_loadu_ps(&m_centerZ[i]);
+        const __m128 ex = _mm_loadu_ps(&m_extentX[i]);
+        const __m128 ey = _mm_loadu_ps(&m_extentY[i]);
+        const __m128 ez = _mm_loadu_ps(&m_extentZ[i]);
+        const __m128 radius = _mm_loadu_ps(&m_radius[i]);
+
+        __m128 outside = zero;
+        for (int p = 0; p < 6; ++p)
+        {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(planes[p][0], cx), planes[p][3]);
+            distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][1], cy));
+            distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][2], cz));
+
+            __m128 boxReach = _mm_mul_ps(absNormals[p][0], ex);
+            boxReach = _mm_add_ps(boxReach, _mm_mul_ps(absNormals[p][1], ey));
+            boxReach = _mm_add_ps(boxReach, _mm_mul_ps(absNormals[p][2], ez));
+
+            const __m128 reach = _mm_min_ps(boxReach, radius);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+        }
+
+        const int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; ++k)
+            m_visible[i + k] = !(mask & (1 << k));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        bool outside = false;
+        for (const glm::vec4& plane : m_planes)
+        {
+            const float distance = plane.x * m_centerX[i] + plane.y * m_centerY[i] + plane.z * m_centerZ[i] + plane.w;
+            const float boxReach = std::fabs(plane.x) * m_extentX[i] + std::fabs(plane.y) * m_extentY[i]
+                                 + std::fabs(plane.z) * m_extentZ[i];
+            outside = outside || distance + std::min(boxReach, m_radius[i]) < 0.0f;
+        }
+        m_visible[i] = !outside;
+    }
+
+    for (unsigned char visible : m_visible)
+    {
+        if (visible)
+            m_stats.visible++;
+        else
+            m_stats.culled++;
+    }
+}
+
+bool FrustumCuller::isVisible(size_t index) const
+{
+    return m_visible[index];
+}
+
+void FrustumCuller::resetStats()
+{
+    m_stats = Stats{};
+}
+
+const FrustumCuller::Stats& FrustumCuller::getStats() const
+{
+    return m_stats;
+}
@@ -0,0 +1,53 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "model.h"
+
+// Tests the world bounds of a frame's objects against the six planes of a
+// projView matrix. Objects are added with their transform, which moves their
+// bounding sphere and box to world space, then cull() tests 4 objects per
+// iteration (SSE) on structure of arrays. An object is culled when its sphere
+// or its box is completely outside a plane.
+class FrustumCuller
+{
+public:
+    struct Stats
+    {
+        int visible;
+        int culled;
+    };
+
+public:
+    FrustumCuller();
+
+    // Clears the objects and extracts the planes of projView
+    void begin(const glm::mat4& projView);
+    // Returns the index of the object for isVisible()
+    size_t add(const Model& model, const glm::mat4& transform);
+    void cull();
+
+    bool isVisible(size_t index) const;
+
+    // Accumulated by cull() until resetStats()
+    void resetStats();
+    const Stats& getStats() const;
+
+private:
+    // xyz normal pointing inside, w distance, normalized
+    glm::vec4 m_planes[6];
+
+    // World bounding sphere radius and box center and half extent
+    std::vector<float> m_centerX, m_centerY, m_centerZ;
+    std::vector<float> m_extentX, m_extentY, m_extentZ;
+    std::vector<float> m_radius;
+    std::vector<unsigned char> m_visible;
+
+    Stats m_stats;
+};
+
+#endif // FRUSTUM_CULLER_H
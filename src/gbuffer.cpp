@@ -0,0 +1,137 @@
+#include "gbuffer.h"
+
+#include <iostream>
+
+#include "gl_state.h"
+
+namespace
+{
+    struct TargetFormat
+    {
+        GLint internalFormat;
+        GLenum format;
+        GLenum type;
+    };
+
+    const TargetFormat TARGET_FORMATS[GBuffer::TARGET_COUNT] = {
+        { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE },  // ALBEDO
+        { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT },   // SPECULAR
+        { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT },   // NORMAL
+        { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT },   // EMISSION
+    };
+
+    GLuint createTarget(int width, int height, GLint internalFormat, GLenum format, GLenum type)
+    {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        GLState::bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        // Read with texelFetch, one texel per pixel
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+}
+
+GBuffer::GBuffer()
+: m_fbo(0)
+, m_textures{}
+, m_depthTexture(0)
+, m_width(0)
+, m_height(0)
+, m_isComplete(false)
+, m_previousFramebuffer(0)
+, m_screenVao()
+, m_screenDraw(m_screenVao, 3)
+{
+}
+
+GBuffer::~GBuffer()
+{
+    release();
+}
+
+bool GBuffer::resize(int width, int height)
+{
+    if (m_fbo && width == m_width && height == m_height)
+        return m_isComplete;
+
+    release();
+    m_width = width;
+    m_height = height;
+
+    GLint previousFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+
+    GLenum drawBuffers[TARGET_COUNT];
+    for (int i = 0; i < TARGET_COUNT; ++i)
+    {
+        const TargetFormat& target = TARGET_FORMATS[i];
+        m_textures[i] = createTarget(width, height, target.internalFormat, target.format, target.type);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_textures[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    glDrawBuffers(TARGET_COUNT, drawBuffers);
+
+    m_depthTexture = createTarget(width, height, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+
+    m_isComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!m_isComplete)
+        std::cout << "G-buffer framebuffer is incomplete (" << width << "x" << height << ")" << std::endl;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    return m_isComplete;
+}
+
+void GBuffer::begin()
+{
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_previousFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbo);
+
+    // Every target is cleared to 0, the lighting pass skips the pixels left
+    // at the far plane
+    const GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat far = 1.0f;
+    for (int i = 0; i < TARGET_COUNT; ++i)
+        glClearBufferfv(GL_COLOR, i, zero);
+    glClearBufferfv(GL_DEPTH, 0, &far);
+}
+
+void GBuffer::end()
+{
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_previousFramebuffer);
+}
+
+void GBuffer::bindTextures(GLuint firstUnit)
+{
+    for (int i = 0; i < TARGET_COUNT; ++i)
+        GLState::bindTexture(firstUnit + i, GL_TEXTURE_2D, m_textures[i]);
+    GLState::bindTexture(firstUnit + TARGET_COUNT, GL_TEXTURE_2D, m_depthTexture);
+}
+
+void GBuffer::drawScreenTriangle()
+{
+    m_screenDraw.draw();
+}
+
+void GBuffer::release()
+{
+    if (!m_fbo)
+        return;
+
+    glDeleteFramebuffers(1, &m_fbo);
+    for (GLuint& texture : m_textures)
+    {
+        GLState::deleteTexture(texture);
+        texture = 0;
+    }
+    GLState::deleteTexture(m_depthTexture);
+    m_depthTexture = 0;
+    m_fbo = 0;
+    m_isComplete = false;
+}
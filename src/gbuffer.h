@@ -0,0 +1,63 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <GL/glew.h>
+
+#include "draw_commands.h"
+#include "vertex_array_object.h"
+
+// Render targets of a deferred pass, the size of the viewport. The geometry
+// pass writes the surface of each pixel between begin() and end(), the
+// lighting pass then reads the targets as textures and shades every covered
+// pixel once, whatever the overdraw.
+class GBuffer
+{
+public:
+    enum Target
+    {
+        ALBEDO,   // diffuse color (RGBA8)
+        SPECULAR, // specular color, shininess in alpha (RGBA16F)
+        NORMAL,   // view space (RGBA16F)
+        EMISSION, // emission plus every ambient term (RGBA16F)
+        TARGET_COUNT
+    };
+
+public:
+    GBuffer();
+    ~GBuffer();
+
+    GBuffer(const GBuffer&) = delete;
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    // Reallocates the targets when the size changed, false if the framebuffer
+    // is incomplete
+    bool resize(int width, int height);
+
+    // Binds and clears the targets for the geometry pass
+    void begin();
+    // Rebinds the framebuffer bound before begin()
+    void end();
+
+    // The targets on units firstUnit to firstUnit + TARGET_COUNT - 1, the
+    // depth on the next one
+    void bindTextures(GLuint firstUnit);
+    // Triangle covering the viewport, its vertices generated from gl_VertexID
+    void drawScreenTriangle();
+
+private:
+    void release();
+
+private:
+    GLuint m_fbo;
+    GLuint m_textures[TARGET_COUNT];
+    GLuint m_depthTexture;
+    int m_width;
+    int m_height;
+    bool m_isComplete;
+    GLint m_previousFramebuffer;
+
+    VertexArrayObject m_screenVao;
+    DrawArraysCommand m_screenDraw;
+};
+
+#endif // GBUFFER_H
@@ -0,0 +1,73 @@
+#include "geometry_pool.h"
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "vertex_format.h"
+
+GeometryPool::GeometryPool(bool quantized)
+: m_quantized(quantized)
+, m_vertexStride(quantized ? sizeof(QuantizedVertex) : 8 * sizeof(GLfloat))
+, m_vertexCount(0)
+{
+}
+
+MeshRange GeometryPool::add(const void* vertexData, GLsizei vertexCount, const GLuint* indices, GLsizei indexCount)
+{
+    MeshRange range = { GLuint(m_indexStaging.size()), indexCount, m_vertexCount };
+
+    const unsigned char* vertices = static_cast<const unsigned char*>(vertexData);
+    m_vertexStaging.insert(m_vertexStaging.end(), vertices, vertices + GLsizeiptr(vertexCount) * m_vertexStride);
+    m_indexStaging.insert(m_indexStaging.end(), indices, indices + indexCount);
+    m_vertexCount += vertexCount;
+    return range;
+}
+
+void GeometryPool::upload()
+{
+    m_vbo.allocate(GL_ARRAY_BUFFER, m_vertexStaging.size(), m_vertexStaging.data(), GL_STATIC_DRAW);
+    m_ebo.allocate(GL_ELEMENT_ARRAY_BUFFER, m_indexStaging.size() * sizeof(GLuint), m_indexStaging.data(), GL_STATIC_DRAW);
+    std::vector<unsigned char>().swap(m_vertexStaging);
+    std::vector<GLuint>().swap(m_indexStaging);
+
+    if (m_quantized)
+    {
+        m_vao.specifyAttribute(m_vbo, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, m_vertexStride, offsetof(QuantizedVertex, position));
+        m_vao.specifyAttribute(m_vbo, 1, 2, GL_HALF_FLOAT, GL_FALSE, m_vertexStride, offsetof(QuantizedVertex, texCoords));
+        m_vao.specifyAttribute(m_vbo, 2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, m_vertexStride, offsetof(QuantizedVertex, normal));
+    }
+    else
+    {
+        m_vao.specifyAttribute(m_vbo, 0, 3, 8, 0);
+        m_vao.specifyAttribute(m_vbo, 1, 2, 8, 3);
+        m_vao.specifyAttribute(m_vbo, 2, 3, 8, 5);
+    }
+    for (GLuint column = 0; column < 4; column++)
+        m_vao.setDivisor(INSTANCE_LOCATION + column, 1);
+    m_vao.setDivisor(INSTANCE_LAYER_LOCATION, 1);
+
+    m_vao.bind();
+    m_ebo.bind();
+    m_vao.unbind();
+}
+
+bool GeometryPool::isQuantized() const
+{
+    return m_quantized;
+}
+
+VertexArrayObject& GeometryPool::getVao()
+{
+    return m_vao;
+}
+
+void GeometryPool::setInstanceBuffer(BufferObject& buffer, GLuint firstInstance)
+{
+    const GLsizeiptr offset = firstInstance * sizeof(InstanceData);
+    for (GLuint column = 0; column < 4; column++)
+        m_vao.specifyAttribute(buffer, INSTANCE_LOCATION + column, 4, GL_FLOAT, GL_FALSE,
+                               sizeof(InstanceData), offset + offsetof(InstanceData, transform) + column * sizeof(glm::vec4));
+    m_vao.specifyAttribute(buffer, INSTANCE_LAYER_LOCATION, 1, GL_FLOAT, GL_FALSE,
+                           sizeof(InstanceData), offset + offsetof(InstanceData, textureLayer));
+}
@@ -0,0 +1,71 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "buffer_object.h"
+#include "vertex_array_object.h"
+
+// Location of a mesh inside a GeometryPool
+struct MeshRange
+{
+    GLuint firstIndex;
+    GLsizei indexCount;
+    GLint baseVertex;
+};
+
+// Level of detail of a mesh, its indices relative to the first of the mesh
+struct MeshLod
+{
+    GLuint firstIndex;
+    GLsizei indexCount;
+    GLfloat error; // distance from the full mesh, in model units
+};
+
+// Per-instance attributes, as stored in instance buffers
+struct InstanceData
+{
+    glm::mat4 transform;
+    GLfloat textureLayer; // layer of a TextureArray, 0 when unused
+    GLfloat padding[3];
+};
+
+// One vertex buffer and one index buffer (GLuint) shared by all the models of
+// a vertex format, behind a single VAO. Meshes are staged on the CPU by add(),
+// and upload() creates the GPU buffers once every model is loaded.
+class GeometryPool
+{
+public:
+    // Per-instance model matrix, a mat4 taking 4 locations from this one
+    static const GLuint INSTANCE_LOCATION = 3;
+    // Per-instance texture layer, a float
+    static const GLuint INSTANCE_LAYER_LOCATION = 7;
+
+    // quantized: vertices are QuantizedVertex, otherwise 8 GLfloats
+    GeometryPool(bool quantized);
+
+    MeshRange add(const void* vertexData, GLsizei vertexCount, const GLuint* indices, GLsizei indexCount);
+    void upload();
+
+    bool isQuantized() const;
+    VertexArrayObject& getVao();
+
+    // Sources the instance attributes from a buffer of InstanceData, instance
+    // 0 reading the one at firstInstance
+    void setInstanceBuffer(BufferObject& buffer, GLuint firstInstance);
+
+private:
+    bool m_quantized;
+    GLsizei m_vertexStride;
+    GLsizei m_vertexCount;
+    std::vector<unsigned char> m_vertexStaging;
+    std::vector<GLuint> m_indexStaging;
+
+    BufferObject m_vbo, m_ebo;
+    VertexArrayObject m_vao;
+};
+
+#endif // GEOMETRY_POOL_H
@@ -0,0 +1,326 @@
+#include "gl_state.h"
+
+namespace
+{
+    const GLuint UNKNOWN = ~0u;
+
+    const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP };
+    const int N_TEXTURE_TARGETS = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+    const GLuint N_TEXTURE_UNITS = 16;
+
+    const GLenum BUFFER_TARGETS[] = {
+        GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_DRAW_INDIRECT_BUFFER,
+        GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_PACK_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+        GL_SHADER_STORAGE_BUFFER,
+    };
+    const int N_BUFFER_TARGETS = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+
+    // Indexed bindings, for GL_UNIFORM_BUFFER and GL_SHADER_STORAGE_BUFFER
+    const GLenum INDEXED_TARGETS[] = { GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER };
+    const int N_INDEXED_TARGETS = sizeof(INDEXED_TARGETS) / sizeof(INDEXED_TARGETS[0]);
+    const GLuint N_BINDING_POINTS = 16;
+
+    const GLenum CAPABILITIES[] = { GL_DEPTH_TEST, GL_STENCIL_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST };
+    const int N_CAPABILITIES = sizeof(CAPABILITIES) / sizeof(CAPABILITIES[0]);
+
+    struct IndexedBinding
+    {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size; // -1 for glBindBufferBase
+    };
+
+    struct State
+    {
+        GLuint program;
+        GLuint activeTexture;
+        GLuint textures[N_TEXTURE_UNITS][N_TEXTURE_TARGETS];
+        GLuint vao;
+        GLuint buffers[N_BUFFER_TARGETS];
+        IndexedBinding indexedBuffers[N_INDEXED_TARGETS][N_BINDING_POINTS];
+        GLint capabilities[N_CAPABILITIES]; // -1 unknown
+        GLenum stencilFunc;
+        GLint stencilRef;
+        GLuint stencilReadMask;
+        GLenum stencilOp[3];
+        GLuint stencilWriteMask;
+        GLenum blendFunc[2];
+    };
+
+    // Everything unknown
+    void reset(State& s)
+    {
+        s.program = UNKNOWN;
+        s.activeTexture = UNKNOWN;
+        for (GLuint unit = 0; unit < N_TEXTURE_UNITS; unit++)
+            for (int target = 0; target < N_TEXTURE_TARGETS; target++)
+                s.textures[unit][target] = UNKNOWN;
+        s.vao = UNKNOWN;
+        for (int target = 0; target < N_BUFFER_TARGETS; target++)
+            s.buffers[target] = UNKNOWN;
+        for (int target = 0; target < N_INDEXED_TARGETS; target++)
+            for (GLuint index = 0; index < N_BINDING_POINTS; index++)
+                s.indexedBuffers[target][index] = { UNKNOWN, 0, 0 };
+        for (int cap = 0; cap < N_CAPABILITIES; cap++)
+            s.capabilities[cap] = -1;
+        s.stencilFunc = GL_NONE;
+        s.stencilOp[0] = s.stencilOp[1] = s.stencilOp[2] = GL_NONE;
+        s.stencilWriteMask = UNKNOWN;
+        s.blendFunc[0] = s.blendFunc[1] = GL_NONE;
+    }
+
+    State unknownState()
+    {
+        State s;
+        reset(s);
+        return s;
+    }
+
+    State state = unknownState();
+
+    GLState::Counters counters = { 0, 0 };
+    GLState::Counters lastFrameCounters = { 0, 0 };
+
+    template <int N>
+    int indexOf(const GLenum (&values)[N], GLenum value)
+    {
+        for (int i = 0; i < N; i++)
+            if (values[i] == value)
+                return i;
+        return -1;
+    }
+
+    // Returns true when the call must be forwarded
+    inline bool changes(bool changed)
+    {
+        if (changed)
+            counters.forwarded++;
+        else
+            counters.elided++;
+        return changed;
+    }
+
+    const int ELEMENT_ARRAY_INDEX = indexOf(BUFFER_TARGETS, GL_ELEMENT_ARRAY_BUFFER);
+}
+
+namespace GLState
+{
+    void invalidate()
+    {
+        reset(state);
+    }
+
+    void beginFrame()
+    {
+        invalidate();
+        lastFrameCounters = counters;
+        counters = { 0, 0 };
+    }
+
+    const Counters& getLastFrameCounters()
+    {
+        return lastFrameCounters;
+    }
+
+    void useProgram(GLuint program)
+    {
+        if (changes(state.program != program))
+        {
+            glUseProgram(program);
+            state.program = program;
+        }
+    }
+
+    void deleteProgram(GLuint program)
+    {
+        glDeleteProgram(program);
+        // A deleted program stays current until replaced, its name may not
+        if (state.program == program)
+            state.program = UNKNOWN;
+    }
+
+    void activeTexture(GLuint unit)
+    {
+        if (changes(state.activeTexture != unit))
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            state.activeTexture = unit;
+        }
+    }
+
+    void bindTexture(GLenum target, GLuint texture)
+    {
+        const int t = indexOf(TEXTURE_TARGETS, target);
+        const GLuint unit = state.activeTexture;
+        if (t < 0 || unit >= N_TEXTURE_UNITS)
+        {
+            // Untracked, the unit may be unknown as well
+            counters.forwarded++;
+            glBindTexture(target, texture);
+            if (t >= 0)
+                for (GLuint u = 0; u < N_TEXTURE_UNITS; u++)
+                    state.textures[u][t] = UNKNOWN;
+            return;
+        }
+
+        if (changes(state.textures[unit][t] != texture))
+        {
+            glBindTexture(target, texture);
+            state.textures[unit][t] = texture;
+        }
+    }
+
+    void bindTexture(GLuint unit, GLenum target, GLuint texture)
+    {
+        const int t = indexOf(TEXTURE_TARGETS, target);
+        if (t >= 0 && unit < N_TEXTURE_UNITS && state.textures[unit][t] == texture)
+        {
+            counters.elided++;
+            return;
+        }
+        activeTexture(unit);
+        bindTexture(target, texture);
+    }
+
+    void deleteTexture(GLuint texture)
+    {
+        glDeleteTextures(1, &texture);
+        for (GLuint unit = 0; unit < N_TEXTURE_UNITS; unit++)
+            for (int target = 0; target < N_TEXTURE_TARGETS; target++)
+                if (state.textures[unit][target] == texture)
+                    state.textures[unit][target] = 0;
+    }
+
+    void bindVertexArray(GLuint vao)
+    {
+        if (changes(state.vao != vao))
+        {
+            glBindVertexArray(vao);
+            state.vao = vao;
+            // The element array binding belongs to the VAO
+            state.buffers[ELEMENT_ARRAY_INDEX] = UNKNOWN;
+        }
+    }
+
+    void deleteVertexArray(GLuint vao)
+    {
+        glDeleteVertexArrays(1, &vao);
+        if (state.vao == vao)
+        {
+            state.vao = 0;
+            state.buffers[ELEMENT_ARRAY_INDEX] = UNKNOWN;
+        }
+    }
+
+    void bindBuffer(GLenum target, GLuint buffer)
+    {
+        const int t = indexOf(BUFFER_TARGETS, target);
+        if (t < 0)
+        {
+            counters.forwarded++;
+            glBindBuffer(target, buffer);
+            return;
+        }
+
+        if (changes(state.buffers[t] != buffer))
+        {
+            glBindBuffer(target, buffer);
+            state.buffers[t] = buffer;
+        }
+    }
+
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+    {
+        bindBufferRange(target, index, buffer, 0, -1);
+    }
+
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+    {
+        const int t = indexOf(INDEXED_TARGETS, target);
+        IndexedBinding* binding = (t >= 0 && index < N_BINDING_POINTS) ? &state.indexedBuffers[t][index] : nullptr;
+        const bool changed = !binding || binding->buffer != buffer || binding->offset != offset || binding->size != size;
+        if (changes(changed))
+        {
+            if (size < 0)
+                glBindBufferBase(target, index, buffer);
+            else
+                glBindBufferRange(target, index, buffer, offset, size);
+            if (binding)
+                *binding = { buffer, offset, size };
+
+            // Both also bind the generic binding point, a skipped bind leaves it
+            const int generic = indexOf(BUFFER_TARGETS, target);
+            if (generic >= 0)
+                state.buffers[generic] = buffer;
+        }
+    }
+
+    void deleteBuffer(GLuint buffer)
+    {
+        glDeleteBuffers(1, &buffer);
+        for (int target = 0; target < N_BUFFER_TARGETS; target++)
+            if (state.buffers[target] == buffer)
+                state.buffers[target] = 0;
+        for (int target = 0; target < N_INDEXED_TARGETS; target++)
+            for (GLuint index = 0; index < N_BINDING_POINTS; index++)
+                if (state.indexedBuffers[target][index].buffer == buffer)
+                    state.indexedBuffers[target][index] = { 0, 0, -1 };
+    }
+
+    void setEnabled(GLenum capability, bool enabled)
+    {
+        const int cap = indexOf(CAPABILITIES, capability);
+        if (cap < 0)
+            counters.forwarded++;
+        else if (changes(state.capabilities[cap] != GLint(enabled)))
+            state.capabilities[cap] = enabled;
+        else
+            return;
+
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    void stencilFunc(GLenum func, GLint ref, GLuint mask)
+    {
+        if (changes(state.stencilFunc != func || state.stencilRef != ref || state.stencilReadMask != mask))
+        {
+            glStencilFunc(func, ref, mask);
+            state.stencilFunc = func;
+            state.stencilRef = ref;
+            state.stencilReadMask = mask;
+        }
+    }
+
+    void stencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+    {
+        if (changes(state.stencilOp[0] != stencilFail || state.stencilOp[1] != depthFail || state.stencilOp[2] != depthPass))
+        {
+            glStencilOp(stencilFail, depthFail, depthPass);
+            state.stencilOp[0] = stencilFail;
+            state.stencilOp[1] = depthFail;
+            state.stencilOp[2] = depthPass;
+        }
+    }
+
+    void stencilMask(GLuint mask)
+    {
+        if (changes(state.stencilWriteMask != mask))
+        {
+            glStencilMask(mask);
+            state.stencilWriteMask = mask;
+        }
+    }
+
+    void blendFunc(GLenum source, GLenum destination)
+    {
+        if (changes(state.blendFunc[0] != source || state.blendFunc[1] != destination))
+        {
+            glBlendFunc(source, destination);
+            state.blendFunc[0] = source;
+            state.blendFunc[1] = destination;
+        }
+    }
+}
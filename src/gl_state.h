@@ -0,0 +1,48 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <GL/glew.h>
+
+// Shadow copy of the GL state set through the wrappers: calls that would not
+// change anything are dropped before reaching the driver. Code changing that
+// state with raw GL calls must go through here too, or call invalidate().
+namespace GLState
+{
+    struct Counters
+    {
+        unsigned int forwarded;
+        unsigned int elided;
+    };
+
+    // Forgets every cached value, the next call of each kind is forwarded
+    void invalidate();
+    // Invalidates, and starts counting a new frame
+    void beginFrame();
+    const Counters& getLastFrameCounters();
+
+    void useProgram(GLuint program);
+    void deleteProgram(GLuint program);
+
+    // unit is an index, not GL_TEXTUREi
+    void activeTexture(GLuint unit);
+    void bindTexture(GLenum target, GLuint texture);
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+    void deleteTexture(GLuint texture);
+
+    void bindVertexArray(GLuint vao);
+    void deleteVertexArray(GLuint vao);
+
+    // GL_ELEMENT_ARRAY_BUFFER is tracked for the bound VAO only
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    void deleteBuffer(GLuint buffer);
+
+    void setEnabled(GLenum capability, bool enabled);
+    void stencilFunc(GLenum func, GLint ref, GLuint mask);
+    void stencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+    void stencilMask(GLuint mask);
+    void blendFunc(GLenum source, GLenum destination);
+}
+
+#endif // GL_STATE_H
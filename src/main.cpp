@@ -1,5 +1,8 @@
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 #include <GL/glew.h>
 
@@ -7,6 +10,8 @@
 
 #include "window.h"
 #include "resources.h"
+#include "gl_state.h"
+#include "benchmark.h"
 
 #include "scenes/scene_stencil.h"
 #include "scenes/scene_lighting.h"
@@ -18,8 +23,22 @@ void printGLInfo();
 int main(int argc, char* argv[])
 {
     const bool VSYNC = false;
+
+    // --bench [--frames N] [--output path]: headless run of scripted camera paths
+    bool bench = false;
+    BenchmarkOptions benchOptions = { 600, 60, "bench.json" };
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            benchOptions.frames = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            benchOptions.outputPath = argv[++i];
+    }
+
     Window w;
-    if (!w.init(VSYNC))
+    if (!w.init(VSYNC, bench))
         return -1;
     
     GLenum rev = glewInit();
@@ -37,13 +56,20 @@ int main(int argc, char* argv[])
     
     Resources res;
     
+    // Everything is decoded in parallel while the scenes upload in order
+    SceneStencil::requestAssets(res.assets);
+    SceneLighting::requestAssets(res.assets);
     SceneStencil  s1(res, isMouseMotionEnabled);
     SceneLighting s2(res, isMouseMotionEnabled);
+    res.assets.release();
     
     glClearColor(0.75f, 0.95f, 0.95f, 1.0f);
-    glEnable(GL_STENCIL_TEST);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
+    GLState::setEnabled(GL_STENCIL_TEST, true);
+    GLState::setEnabled(GL_DEPTH_TEST, true);
+    GLState::setEnabled(GL_CULL_FACE, true);
+    
+    if (bench)
+        return runBenchmark(w, res, s1, s2, benchOptions);
     
     const char* const SCENE_NAMES[] = {
         "Stencil",
@@ -71,8 +97,15 @@ int main(int argc, char* argv[])
         // TODO: Pour scène de stencil
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
+        // ImGui changes the state behind the tracker when it renders
+        GLState::beginFrame();
+        res.profiler.beginFrame();
+        res.textureStreamer.update();
+        const GLState::Counters& glCalls = GLState::getLastFrameCounters();
+
         ImGui::Begin("Scene Parameters");
         ImGui::Combo("Scene", &currentScene, SCENE_NAMES, N_SCENE_NAMES);
+        ImGui::Text("GL state calls: %u forwarded, %u elided", glCalls.forwarded, glCalls.elided);
         ImGui::End();
         
         if (w.getKeyPress(Window::Key::SPACE))
@@ -91,6 +124,7 @@ int main(int argc, char* argv[])
             case 0: s1.run(w, dt); break;
             case 1: s2.run(w, dt); break;
         }       
+        res.profiler.drawPanel();
         
         w.swap();
         w.pollEvent();
@@ -0,0 +1,114 @@
+#include "mapped_file.h"
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+: m_data(nullptr)
+, m_size(0)
+, m_mtime(0)
+, m_isMapped(false)
+{
+}
+
+MappedFile::MappedFile(const char* path)
+: MappedFile()
+{
+    open(path);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const char* path)
+{
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_size = st.st_size;
+    m_mtime = st.st_mtime;
+
+    if (m_size == 0)
+    {
+        // mmap refuses empty ranges, but an empty file is still a valid file
+        ::close(fd);
+        m_data = "";
+        return true;
+    }
+
+    void* addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        m_size = 0;
+        return false;
+    }
+    madvise(addr, m_size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<const char*>(addr);
+    m_isMapped = true;
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+
+    m_size = file.tellg();
+    m_fallback.resize(m_size + 1);
+    file.seekg(0);
+    file.read(m_fallback.data(), m_size);
+    m_data = m_fallback.data();
+    return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+    if (m_isMapped)
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    m_fallback.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_mtime = 0;
+    m_isMapped = false;
+}
+
+bool MappedFile::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+const char* MappedFile::data() const
+{
+    return m_data;
+}
+
+size_t MappedFile::size() const
+{
+    return m_size;
+}
+
+int64_t MappedFile::modificationTime() const
+{
+    return m_mtime;
+}
@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Read-only view of a whole file. Uses mmap where available, otherwise
+// falls back to reading the file into memory.
+class MappedFile
+{
+public:
+    MappedFile();
+    MappedFile(const char* path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path);
+    void close();
+
+    bool isOpen() const;
+
+    const char* data() const;
+    size_t size() const;
+
+    int64_t modificationTime() const;
+
+private:
+    const char* m_data;
+    size_t m_size;
+    int64_t m_mtime;
+    bool m_isMapped;
+    std::vector<char> m_fallback;
+};
+
+#endif // MAPPED_FILE_H
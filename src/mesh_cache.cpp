@@ -0,0 +1,254 @@
+#include "mesh_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char MAGIC[4] = { 'M', 'S', 'H', 'C' };
+    const uint64_t BLOCK_ALIGNMENT = 16;
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // The same mesh loaded with other flags gets its own file, so the caches
+    // don't keep replacing each other
+    std::string getCachePath(const std::string& sourcePath, uint32_t flags)
+    {
+        if (flags == 0)
+            return sourcePath + ".meshcache";
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), ".%x", flags);
+        return sourcePath + suffix + ".meshcache";
+    }
+
+    // Unique to the process and the thread writing
+    std::string getWriterId()
+    {
+#ifdef _WIN32
+        const long processId = _getpid();
+#else
+        const long processId = getpid();
+#endif
+        return std::to_string(processId) + "-" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    }
+}
+
+MeshCache::MeshCache(const char* sourcePath, uint32_t flags)
+: m_sourcePath(sourcePath)
+, m_cachePath(getCachePath(m_sourcePath, flags))
+, m_flags(flags)
+, m_header(nullptr)
+{
+}
+
+bool MeshCache::load()
+{
+    m_header = nullptr;
+    if (!m_file.open(m_cachePath.c_str()))
+        return false;
+
+    if (m_file.size() < sizeof(MeshCacheHeader))
+        return false;
+
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(m_file.data());
+    if (!isValid(*header))
+    {
+        m_file.close();
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+bool MeshCache::store(const void* vertexData, GLsizei vertexStride, GLsizei vertexCount,
+                      const GLuint* indices, GLsizei indexCount,
+                      const GLfloat boundsMin[3], const GLfloat boundsMax[3], GLfloat boundingRadius,
+                      const MeshLod* lods, uint32_t lodCount, const Meshlet* meshlets, uint32_t meshletCount)
+{
+    if (lodCount > MAX_LODS)
+        return false;
+
+    MappedFile source(m_sourcePath.c_str());
+    if (!source.isOpen())
+        return false;
+
+    MeshCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.sourceHash = hash(source.data(), source.size());
+    header.sourceSize = source.size();
+    header.sourceMtime = source.modificationTime();
+    header.vertexStride = vertexStride;
+    header.vertexCount = vertexCount;
+    header.indexCount = indexCount;
+    header.flags = m_flags;
+    std::memcpy(header.boundsMin, boundsMin, sizeof(header.boundsMin));
+    std::memcpy(header.boundsMax, boundsMax, sizeof(header.boundsMax));
+    header.boundingRadius = boundingRadius;
+    header.lodCount = lodCount;
+    std::copy(lods, lods + lodCount, header.lods);
+    header.meshletCount = meshletCount;
+
+    const uint64_t vertexBytes = uint64_t(vertexStride) * vertexCount;
+    const uint64_t indexBytes = uint64_t(indexCount) * sizeof(GLuint);
+    header.vertexOffset = alignUp(sizeof(header), BLOCK_ALIGNMENT);
+    const uint64_t meshletBytes = uint64_t(meshletCount) * sizeof(Meshlet);
+    header.indexOffset = alignUp(header.vertexOffset + vertexBytes, BLOCK_ALIGNMENT);
+    header.meshletOffset = alignUp(header.indexOffset + indexBytes, BLOCK_ALIGNMENT);
+
+    // Write beside the final file and rename, so a concurrent or interrupted
+    // run never maps a half-written cache. Each writer has its own temporary
+    // file, one rename can't move another writer's partial file.
+    const std::string tmpPath = m_cachePath + "." + getWriterId() + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cout << "Unable to write mesh cache " << m_cachePath << std::endl;
+            return false;
+        }
+
+        const char padding[BLOCK_ALIGNMENT] = {};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(padding, header.vertexOffset - sizeof(header));
+        file.write(static_cast<const char*>(vertexData), vertexBytes);
+        file.write(padding, header.indexOffset - (header.vertexOffset + vertexBytes));
+        file.write(reinterpret_cast<const char*>(indices), indexBytes);
+        file.write(padding, header.meshletOffset - (header.indexOffset + indexBytes));
+        file.write(reinterpret_cast<const char*>(meshlets), meshletBytes);
+
+        if (!file.good())
+        {
+            file.close();
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    return std::rename(tmpPath.c_str(), m_cachePath.c_str()) == 0;
+}
+
+const void* MeshCache::vertexData() const
+{
+    return m_file.data() + m_header->vertexOffset;
+}
+
+GLsizeiptr MeshCache::vertexDataSize() const
+{
+    return GLsizeiptr(m_header->vertexStride) * m_header->vertexCount;
+}
+
+const GLuint* MeshCache::indexData() const
+{
+    return reinterpret_cast<const GLuint*>(m_file.data() + m_header->indexOffset);
+}
+
+GLsizeiptr MeshCache::indexDataSize() const
+{
+    return GLsizeiptr(m_header->indexCount) * sizeof(GLuint);
+}
+
+GLsizei MeshCache::indexCount() const
+{
+    return m_header->indexCount;
+}
+
+const GLfloat* MeshCache::boundsMin() const
+{
+    return m_header->boundsMin;
+}
+
+const GLfloat* MeshCache::boundsMax() const
+{
+    return m_header->boundsMax;
+}
+
+GLfloat MeshCache::boundingRadius() const
+{
+    return m_header->boundingRadius;
+}
+
+const MeshLod* MeshCache::lods() const
+{
+    return m_header->lods;
+}
+
+uint32_t MeshCache::lodCount() const
+{
+    return m_header->lodCount;
+}
+
+const Meshlet* MeshCache::meshlets() const
+{
+    return reinterpret_cast<const Meshlet*>(m_file.data() + m_header->meshletOffset);
+}
+
+uint32_t MeshCache::meshletCount() const
+{
+    return m_header->meshletCount;
+}
+
+// FNV-1a, 64 bits
+uint64_t MeshCache::hash(const char* data, size_t size)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+bool MeshCache::isValid(const MeshCacheHeader& header) const
+{
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+        return false;
+    if (header.flags != m_flags)
+        return false;
+    if (header.lodCount == 0 || header.lodCount > MAX_LODS)
+        return false;
+    for (uint32_t i = 0; i < header.lodCount; ++i)
+        if (uint64_t(header.lods[i].firstIndex) + header.lods[i].indexCount > header.indexCount)
+            return false;
+
+    const uint64_t vertexBytes = uint64_t(header.vertexStride) * header.vertexCount;
+    const uint64_t indexBytes = uint64_t(header.indexCount) * sizeof(GLuint);
+    const uint64_t meshletBytes = uint64_t(header.meshletCount) * sizeof(Meshlet);
+    if (header.vertexOffset + vertexBytes > m_file.size() || header.indexOffset + indexBytes > m_file.size()
+        || header.meshletOffset + meshletBytes > m_file.size())
+        return false;
+    if (header.meshletCount > 0)
+    {
+        const Meshlet& last = reinterpret_cast<const Meshlet*>(m_file.data() + header.meshletOffset)[header.meshletCount - 1];
+        if (uint64_t(last.firstIndex) + last.indexCount > uint64_t(header.lods[0].indexCount))
+            return false;
+    }
+
+    // Only stat the source on the fast path; its content is hashed only when
+    // the timestamp moved (e.g. after a fresh checkout) to confirm a real edit.
+    struct stat st;
+    if (stat(m_sourcePath.c_str(), &st) != 0 || uint64_t(st.st_size) != header.sourceSize)
+        return false;
+    if (int64_t(st.st_mtime) == header.sourceMtime)
+        return true;
+
+    MappedFile source(m_sourcePath.c_str());
+    return source.isOpen() && hash(source.data(), source.size()) == header.sourceHash;
+}
@@ -0,0 +1,79 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "geometry_pool.h"
+#include "mapped_file.h"
+#include "meshlet_builder.h"
+
+// Binary image of a loaded mesh, stored next to its .obj as "<path>[.flags].meshcache".
+// The vertex and index blocks are laid out exactly as they are uploaded, so a
+// warm load is a single mmap followed by the buffer allocations.
+struct MeshCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t flags;
+    float boundsMin[3];
+    float boundsMax[3];
+    float boundingRadius;
+    uint32_t lodCount;
+    MeshLod lods[4]; // MeshCache::MAX_LODS
+    uint32_t meshletCount;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletOffset;
+};
+
+class MeshCache
+{
+public:
+    static const uint32_t VERSION = 7;
+    static const uint32_t MAX_LODS = 4;
+
+    // flags identify the processing applied to the mesh (see Model::Flags)
+    MeshCache(const char* sourcePath, uint32_t flags = 0);
+
+    bool load();
+    bool store(const void* vertexData, GLsizei vertexStride, GLsizei vertexCount,
+               const GLuint* indices, GLsizei indexCount,
+               const GLfloat boundsMin[3], const GLfloat boundsMax[3], GLfloat boundingRadius,
+               const MeshLod* lods, uint32_t lodCount, const Meshlet* meshlets, uint32_t meshletCount);
+
+    const void* vertexData() const;
+    GLsizeiptr vertexDataSize() const;
+    const GLuint* indexData() const;
+    GLsizeiptr indexDataSize() const;
+    GLsizei indexCount() const;
+    const GLfloat* boundsMin() const;
+    const GLfloat* boundsMax() const;
+    GLfloat boundingRadius() const;
+    const MeshLod* lods() const;
+    uint32_t lodCount() const;
+    const Meshlet* meshlets() const;
+    uint32_t meshletCount() const;
+
+    static uint64_t hash(const char* data, size_t size);
+
+private:
+    bool isValid(const MeshCacheHeader& header) const;
+
+private:
+    std::string m_sourcePath;
+    std::string m_cachePath;
+    uint32_t m_flags;
+    MappedFile m_file;
+    const MeshCacheHeader* m_header;
+};
+
+#endif // MESH_CACHE_H
@@ -0,0 +1,186 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Tuning values from the paper
+    const int CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRI_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    float vertexScore(int cachePosition, unsigned int remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            // The three vertices of the last triangle get a fixed score so
+            // the next triangle isn't forced to reuse them in a fixed order.
+            if (cachePosition < 3)
+                score = LAST_TRI_SCORE;
+            else
+                score = std::pow(1.0f - float(cachePosition - 3) / (CACHE_SIZE - 3), CACHE_DECAY_POWER);
+        }
+        score += VALENCE_BOOST_SCALE * std::pow(float(remainingTriangles), -VALENCE_BOOST_POWER);
+        return score;
+    }
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, size_t cacheSize)
+{
+    VertexCacheStats stats = { 0.0f, 0.0f };
+    if (indices.empty() || vertexCount == 0)
+        return stats;
+
+    // FIFO, the replacement policy of actual post-transform caches
+    std::vector<size_t> insertedAt(vertexCount, 0);
+    size_t misses = 0;
+    for (GLuint v : indices)
+    {
+        if (insertedAt[v] == 0 || misses - insertedAt[v] + 1 > cacheSize)
+        {
+            ++misses;
+            insertedAt[v] = misses;
+        }
+    }
+
+    stats.acmr = float(misses) / (indices.size() / 3);
+    stats.atvr = float(misses) / vertexCount;
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Triangles adjacent to each vertex; the first remaining[v] entries of
+    // each range are the triangles not emitted yet.
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (GLuint v : indices)
+        ++remaining[v];
+
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = i / 3;
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<GLuint> output;
+    output.reserve(indices.size());
+
+    std::vector<GLuint> cache, newCache;
+    cache.reserve(CACHE_SIZE + 3);
+    newCache.reserve(CACHE_SIZE + 3);
+
+    long bestTriangle = std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin();
+    while (output.size() < indices.size())
+    {
+        if (bestTriangle < 0)
+        {
+            // Nothing left around the cache: restart from the best triangle
+            // anywhere. Only happens between disconnected parts.
+            float best = -1.0f;
+            for (size_t t = 0; t < triangleCount; ++t)
+            {
+                if (!emitted[t] && triangleScore[t] > best)
+                {
+                    best = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        const GLuint* tri = &indices[bestTriangle * 3];
+        output.insert(output.end(), tri, tri + 3);
+        emitted[bestTriangle] = true;
+
+        newCache.clear();
+        for (int k = 0; k < 3; ++k)
+        {
+            const GLuint v = tri[k];
+            unsigned int* begin = &adjacency[offsets[v]];
+            unsigned int* end = begin + remaining[v];
+            std::iter_swap(std::find(begin, end, unsigned(bestTriangle)), end - 1);
+            --remaining[v];
+
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+                newCache.push_back(v);
+        }
+        for (GLuint v : cache)
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+                newCache.push_back(v);
+
+        for (size_t i = 0; i < newCache.size(); ++i)
+        {
+            const GLuint v = newCache[i];
+            cachePosition[v] = i < CACHE_SIZE ? int(i) : -1;
+            score[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+
+        bestTriangle = -1;
+        float best = -1.0f;
+        for (GLuint v : newCache)
+        {
+            for (unsigned int i = 0; i < remaining[v]; ++i)
+            {
+                const unsigned int t = adjacency[offsets[v] + i];
+                triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                if (triangleScore[t] > best)
+                {
+                    best = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cache.assign(newCache.begin(), newCache.begin() + std::min<size_t>(newCache.size(), CACHE_SIZE));
+    }
+
+    indices.swap(output);
+}
+
+void optimizeVertexFetch(std::vector<GLfloat>& vertexData, size_t vertexSize, std::vector<GLuint>& indices)
+{
+    const size_t vertexCount = vertexData.size() / vertexSize;
+    const GLuint UNUSED = ~0u;
+
+    std::vector<GLuint> remap(vertexCount, UNUSED);
+    std::vector<GLfloat> reordered;
+    reordered.reserve(vertexData.size());
+
+    GLuint next = 0;
+    for (GLuint& index : indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = next++;
+            const GLfloat* vertex = &vertexData[index * vertexSize];
+            reordered.insert(reordered.end(), vertex, vertex + vertexSize);
+        }
+        index = remap[index];
+    }
+
+    // Vertices no triangle uses are dropped
+    vertexData.swap(reordered);
+}
@@ -0,0 +1,29 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Post-transform vertex cache efficiency of an index buffer, measured on a
+// simulated FIFO cache.
+// ACMR: vertex shader invocations per triangle (0.5 is ideal on closed meshes)
+// ATVR: vertex shader invocations per vertex (1.0 is ideal)
+struct VertexCacheStats
+{
+    float acmr;
+    float atvr;
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, size_t cacheSize = 16);
+
+// Reorders triangles for post-transform cache locality (Forsyth, "Linear-Speed
+// Vertex Cache Optimisation").
+void optimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount);
+
+// Reorders vertices in the order the index buffer first references them, so
+// vertex fetches walk memory forward. vertexSize is in GLfloats.
+void optimizeVertexFetch(std::vector<GLfloat>& vertexData, size_t vertexSize, std::vector<GLuint>& indices);
+
+#endif // MESH_OPTIMIZER_H
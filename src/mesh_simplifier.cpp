@@ -0,0 +1,307 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <utility>
+
+namespace
+{
+    // Symmetric 4x4 matrix: xx, xy, xz, xw, yy, yz, yw, zz, zw, ww
+    struct Quadric
+    {
+        double q[10];
+        double planes;
+
+        void addPlane(double a, double b, double c, double d)
+        {
+            q[0] += a * a; q[1] += a * b; q[2] += a * c; q[3] += a * d;
+            q[4] += b * b; q[5] += b * c; q[6] += b * d;
+            q[7] += c * c; q[8] += c * d;
+            q[9] += d * d;
+            planes += 1.0;
+        }
+
+        void add(const Quadric& other)
+        {
+            for (int i = 0; i < 10; ++i)
+                q[i] += other.q[i];
+            planes += other.planes;
+        }
+
+        // Mean of the squared distances to the accumulated planes
+        double error(const GLfloat* p) const
+        {
+            if (planes == 0.0)
+                return 0.0;
+            const double x = p[0], y = p[1], z = p[2];
+            return (x * x * q[0] + 2 * x * y * q[1] + 2 * x * z * q[2] + 2 * x * q[3]
+                 + y * y * q[4] + 2 * y * z * q[5] + 2 * y * q[6]
+                 + z * z * q[7] + 2 * z * q[8]
+                 + q[9]) / planes;
+        }
+    };
+
+    struct Collapse
+    {
+        double error;
+        GLuint from;
+        GLuint to;
+        bool operator<(const Collapse& other) const { return error < other.error; }
+    };
+
+    // Share of the remaining collapses tried in one pass, the cheapest ones
+    const float PASS_FRACTION = 0.2f;
+    // A level removing less than this share of the previous one ends the chain
+    const float MIN_REDUCTION = 0.1f;
+    // cos of the largest rotation of a triangle's normal caused by a collapse
+    const double MAX_NORMAL_ROTATION = 0.25;
+
+    void cross(const GLfloat* a, const GLfloat* b, const GLfloat* c, double n[3])
+    {
+        const double e1[3] = { double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2] };
+        const double e2[3] = { double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2] };
+        n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+
+    class Simplifier
+    {
+    public:
+        Simplifier(const std::vector<GLfloat>& vertexData, size_t vertexSize, const std::vector<GLuint>& indices)
+        : m_vertexData(vertexData)
+        , m_vertexSize(vertexSize)
+        , m_vertexCount(vertexData.size() / vertexSize)
+        , m_indices(indices)
+        , m_error(0.0)
+        {
+            findPositions();
+            lockBorders();
+            computeQuadrics();
+        }
+
+        // Collapses until at most targetIndexCount indices remain, or nothing can move
+        void simplify(size_t targetIndexCount)
+        {
+            while (m_indices.size() > targetIndexCount)
+            {
+                if (!collapsePass((m_indices.size() - targetIndexCount) / 3))
+                    break;
+            }
+        }
+
+        const std::vector<GLuint>& indices() const { return m_indices; }
+        GLfloat error() const { return GLfloat(std::sqrt(m_error)); }
+
+    private:
+        const GLfloat* position(GLuint v) const
+        {
+            return &m_vertexData[v * m_vertexSize];
+        }
+
+        // Vertices sharing a position (split by normals or texture
+        // coordinates) get one position id, and are locked
+        void findPositions()
+        {
+            std::map<std::array<GLfloat, 3>, GLuint> ids;
+            std::vector<unsigned int> wedges;
+            m_positionId.resize(m_vertexCount);
+            for (size_t v = 0; v < m_vertexCount; ++v)
+            {
+                const GLfloat* p = position(v);
+                auto inserted = ids.insert({ { p[0], p[1], p[2] }, GLuint(wedges.size()) });
+                if (inserted.second)
+                    wedges.push_back(0);
+                m_positionId[v] = inserted.first->second;
+                wedges[m_positionId[v]]++;
+            }
+
+            m_locked.assign(wedges.size(), false);
+            for (size_t i = 0; i < wedges.size(); ++i)
+                m_locked[i] = wedges[i] > 1;
+        }
+
+        // Edges used by one triangle (border) or more than two (non manifold)
+        void lockBorders()
+        {
+            std::map<std::pair<GLuint, GLuint>, int> edges;
+            for (size_t t = 0; t < m_indices.size(); t += 3)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    GLuint a = m_positionId[m_indices[t + k]];
+                    GLuint b = m_positionId[m_indices[t + (k + 1) % 3]];
+                    edges[{ std::min(a, b), std::max(a, b) }]++;
+                }
+            }
+            for (const auto& edge : edges)
+            {
+                if (edge.second != 2)
+                {
+                    m_locked[edge.first.first] = true;
+                    m_locked[edge.first.second] = true;
+                }
+            }
+        }
+
+        void computeQuadrics()
+        {
+            m_quadrics.assign(m_locked.size(), Quadric{});
+            for (size_t t = 0; t < m_indices.size(); t += 3)
+            {
+                const GLfloat* p0 = position(m_indices[t]);
+                double n[3];
+                cross(p0, position(m_indices[t + 1]), position(m_indices[t + 2]), n);
+                const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length == 0.0)
+                    continue;
+                for (double& c : n)
+                    c /= length;
+                const double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+                for (int k = 0; k < 3; ++k)
+                    m_quadrics[m_positionId[m_indices[t + k]]].addPlane(n[0], n[1], n[2], d);
+            }
+        }
+
+        // Applies the cheapest independent collapses, returns false when none was possible
+        bool collapsePass(size_t trianglesToRemove)
+        {
+            // Triangles around each vertex
+            std::vector<unsigned int> offsets(m_vertexCount + 1, 0);
+            for (GLuint v : m_indices)
+                offsets[v + 1]++;
+            for (size_t v = 0; v < m_vertexCount; ++v)
+                offsets[v + 1] += offsets[v];
+            std::vector<unsigned int> adjacency(m_indices.size());
+            std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < m_indices.size(); ++i)
+                adjacency[fill[m_indices[i]]++] = i / 3;
+
+            std::vector<Collapse> collapses;
+            for (size_t t = 0; t < m_indices.size(); t += 3)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    const GLuint a = m_indices[t + k];
+                    const GLuint b = m_indices[t + (k + 1) % 3];
+                    if (!m_locked[m_positionId[a]])
+                        collapses.push_back({ cost(a, b), a, b });
+                    if (!m_locked[m_positionId[b]])
+                        collapses.push_back({ cost(b, a), b, a });
+                }
+            }
+            std::sort(collapses.begin(), collapses.end());
+
+            // Each collapse removes about two triangles
+            const size_t limit = std::max<size_t>(1, std::min(trianglesToRemove / 2 + 1,
+                                                              size_t(collapses.size() * PASS_FRACTION)));
+            std::vector<bool> touched(m_vertexCount, false);
+            std::vector<GLuint> remap(m_vertexCount);
+            for (size_t v = 0; v < m_vertexCount; ++v)
+                remap[v] = v;
+
+            size_t applied = 0;
+            for (const Collapse& collapse : collapses)
+            {
+                if (applied >= limit)
+                    break;
+                if (touched[collapse.from] || touched[collapse.to])
+                    continue;
+                if (flipsTriangle(collapse, adjacency, offsets))
+                    continue;
+
+                // The triangles of from change, their vertices wait for the next pass
+                for (unsigned int i = offsets[collapse.from]; i < offsets[collapse.from + 1]; ++i)
+                    for (int k = 0; k < 3; ++k)
+                        touched[m_indices[adjacency[i] * 3 + k]] = true;
+
+                remap[collapse.from] = collapse.to;
+                m_quadrics[m_positionId[collapse.to]].add(m_quadrics[m_positionId[collapse.from]]);
+                m_error = std::max(m_error, collapse.error);
+                applied++;
+            }
+            if (applied == 0)
+                return false;
+
+            size_t kept = 0;
+            for (size_t t = 0; t < m_indices.size(); t += 3)
+            {
+                const GLuint a = remap[m_indices[t]], b = remap[m_indices[t + 1]], c = remap[m_indices[t + 2]];
+                if (m_positionId[a] == m_positionId[b] || m_positionId[b] == m_positionId[c]
+                    || m_positionId[a] == m_positionId[c])
+                    continue;
+                m_indices[kept++] = a;
+                m_indices[kept++] = b;
+                m_indices[kept++] = c;
+            }
+            m_indices.resize(kept);
+            return true;
+        }
+
+        double cost(GLuint from, GLuint to) const
+        {
+            Quadric q = m_quadrics[m_positionId[from]];
+            q.add(m_quadrics[m_positionId[to]]);
+            return std::max(0.0, q.error(position(to)));
+        }
+
+        bool flipsTriangle(const Collapse& collapse, const std::vector<unsigned int>& adjacency,
+                           const std::vector<unsigned int>& offsets) const
+        {
+            for (unsigned int i = offsets[collapse.from]; i < offsets[collapse.from + 1]; ++i)
+            {
+                const GLuint* triangle = &m_indices[adjacency[i] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                    continue; // removed by the collapse
+
+                const GLfloat* before[3];
+                const GLfloat* after[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    before[k] = position(triangle[k]);
+                    after[k] = triangle[k] == collapse.from ? position(collapse.to) : before[k];
+                }
+                double n0[3], n1[3];
+                cross(before[0], before[1], before[2], n0);
+                cross(after[0], after[1], after[2], n1);
+                const double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+                const double lengths = std::sqrt((n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2])
+                                                 * (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]));
+                if (dot <= MAX_NORMAL_ROTATION * lengths)
+                    return true;
+            }
+            return false;
+        }
+
+    private:
+        const std::vector<GLfloat>& m_vertexData;
+        size_t m_vertexSize;
+        size_t m_vertexCount;
+
+        std::vector<GLuint> m_indices;
+        std::vector<GLuint> m_positionId;
+        std::vector<bool> m_locked;        // per position id
+        std::vector<Quadric> m_quadrics;   // per position id
+        double m_error;
+    };
+}
+
+std::vector<SimplifiedLevel> simplifyMesh(const std::vector<GLfloat>& vertexData, size_t vertexSize,
+                                          const std::vector<GLuint>& indices, const std::vector<float>& ratios)
+{
+    std::vector<SimplifiedLevel> levels;
+    Simplifier simplifier(vertexData, vertexSize, indices);
+    size_t previousCount = indices.size();
+    for (float ratio : ratios)
+    {
+        simplifier.simplify(size_t(indices.size() * ratio) / 3 * 3);
+        const size_t count = simplifier.indices().size();
+        if (count == 0 || count > previousCount * (1.0f - MIN_REDUCTION))
+            break;
+        levels.push_back({ simplifier.indices(), simplifier.error() });
+        previousCount = count;
+    }
+    return levels;
+}
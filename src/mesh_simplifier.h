@@ -0,0 +1,27 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+struct SimplifiedLevel
+{
+    std::vector<GLuint> indices;
+    // Approximate distance from the original surface, in model units
+    GLfloat error;
+};
+
+// Quadric error edge collapse (Garland and Heckbert, "Surface Simplification
+// Using Quadric Error Metrics") restricted to the existing vertices: a vertex
+// is moved onto a neighbour, so every level indexes the original vertex
+// buffer. Vertices on borders and attribute seams (one position, several
+// vertices) stay in place.
+// One level per ratio of the original index count, each one simplified from
+// the previous. The chain stops early once a level barely reduces the
+// previous one. vertexSize is in GLfloats, the position coming first.
+std::vector<SimplifiedLevel> simplifyMesh(const std::vector<GLfloat>& vertexData, size_t vertexSize,
+                                          const std::vector<GLuint>& indices, const std::vector<float>& ratios);
+
+#endif // MESH_SIMPLIFIER_H
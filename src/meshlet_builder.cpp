@@ -0,0 +1,238 @@
+#include "meshlet_builder.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+
+namespace
+{
+    // Below this cos of the cone's half angle (about 84 degrees), the cone
+    // only culls from nearly behind the meshlet and isn't worth testing
+    const float MIN_CONE_DOT = 0.1f;
+
+    // Weight of the normal deviation against one more vertex when growing
+    const float CONE_WEIGHT = 2.0f;
+    // cos of the largest angle between a new triangle and the average normal
+    const float MIN_GROWTH_DOT = 0.7f;
+
+    struct Normal
+    {
+        float n[3];
+        bool valid; // false for degenerate triangles
+    };
+
+    // From the counter-clockwise winding
+    Normal faceNormal(const std::vector<GLfloat>& vertexData, size_t vertexSize, const GLuint* triangle)
+    {
+        const GLfloat* a = &vertexData[triangle[0] * vertexSize];
+        const GLfloat* b = &vertexData[triangle[1] * vertexSize];
+        const GLfloat* c = &vertexData[triangle[2] * vertexSize];
+        const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        Normal normal = { { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] },
+                          false };
+        const float length = std::sqrt(normal.n[0] * normal.n[0] + normal.n[1] * normal.n[1] + normal.n[2] * normal.n[2]);
+        if (length > 0.0f)
+        {
+            for (float& n : normal.n)
+                n /= length;
+            normal.valid = true;
+        }
+        return normal;
+    }
+
+    void finishMeshlet(const std::vector<GLfloat>& vertexData, size_t vertexSize, const std::vector<GLuint>& indices,
+                       Meshlet& meshlet)
+    {
+        const GLuint end = meshlet.firstIndex + meshlet.indexCount;
+
+        // Sphere around the bounding box of the positions
+        float boundsMin[3] = { INFINITY, INFINITY, INFINITY };
+        float boundsMax[3] = { -INFINITY, -INFINITY, -INFINITY };
+        for (GLuint i = meshlet.firstIndex; i < end; ++i)
+        {
+            const GLfloat* p = &vertexData[indices[i] * vertexSize];
+            for (int c = 0; c < 3; ++c)
+            {
+                boundsMin[c] = std::min(boundsMin[c], p[c]);
+                boundsMax[c] = std::max(boundsMax[c], p[c]);
+            }
+        }
+        for (int c = 0; c < 3; ++c)
+            meshlet.center[c] = (boundsMin[c] + boundsMax[c]) * 0.5f;
+
+        float radius2 = 0.0f;
+        for (GLuint i = meshlet.firstIndex; i < end; ++i)
+        {
+            const GLfloat* p = &vertexData[indices[i] * vertexSize];
+            const float dx = p[0] - meshlet.center[0], dy = p[1] - meshlet.center[1], dz = p[2] - meshlet.center[2];
+            radius2 = std::max(radius2, dx * dx + dy * dy + dz * dz);
+        }
+        meshlet.radius = std::sqrt(radius2);
+
+        // Degenerate triangles are ignored
+        std::vector<Normal> normals;
+        float axis[3] = { 0.0f, 0.0f, 0.0f };
+        for (GLuint i = meshlet.firstIndex; i < end; i += 3)
+        {
+            const Normal normal = faceNormal(vertexData, vertexSize, &indices[i]);
+            if (!normal.valid)
+                continue;
+            for (int k = 0; k < 3; ++k)
+                axis[k] += normal.n[k];
+            normals.push_back(normal);
+        }
+
+        const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        float minDot = -1.0f;
+        if (axisLength > 0.0f)
+        {
+            minDot = 1.0f;
+            for (int k = 0; k < 3; ++k)
+                axis[k] /= axisLength;
+            for (const Normal& normal : normals)
+                minDot = std::min(minDot, axis[0] * normal.n[0] + axis[1] * normal.n[1] + axis[2] * normal.n[2]);
+        }
+
+        for (int k = 0; k < 3; ++k)
+            meshlet.coneAxis[k] = axis[k];
+        meshlet.coneCutoff = minDot < MIN_CONE_DOT ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+void buildMeshlets(const std::vector<GLfloat>& vertexData, size_t vertexSize, std::vector<GLuint>& indices,
+                   std::vector<Meshlet>& meshlets, size_t maxVertices, size_t maxTriangles)
+{
+    meshlets.clear();
+    const size_t triangleCount = indices.size() / 3;
+    const size_t vertexCount = vertexData.size() / vertexSize;
+
+    // Triangles are neighbours when they share a position: seams split the
+    // vertices but not the surface
+    std::vector<GLuint> positionIds(vertexCount);
+    {
+        std::map<std::array<GLfloat, 3>, GLuint> ids;
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            const GLfloat* p = &vertexData[v * vertexSize];
+            positionIds[v] = ids.insert({ { p[0], p[1], p[2] }, GLuint(ids.size()) }).first->second;
+        }
+    }
+    std::vector<std::vector<GLuint>> positionTriangles(vertexCount);
+    std::vector<Normal> normals(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+            positionTriangles[positionIds[indices[t * 3 + k]]].push_back(t);
+        normals[t] = faceNormal(vertexData, vertexSize, &indices[t * 3]);
+    }
+
+    std::vector<GLuint> ordered;
+    ordered.reserve(indices.size());
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<GLuint> stamps(vertexCount, 0); // meshlet (plus one) that last used each vertex
+    std::vector<GLuint> candidates;
+
+    size_t seed = 0;
+    while (true)
+    {
+        while (seed < triangleCount && emitted[seed])
+            ++seed;
+        if (seed == triangleCount)
+            break;
+
+        // Grown from the first remaining triangle, by the neighbour adding the
+        // fewest vertices and staying closest to the average normal
+        const GLuint stamp = meshlets.size() + 1;
+        Meshlet meshlet = {};
+        meshlet.firstIndex = ordered.size();
+        size_t meshletVertices = 0;
+        float axis[3] = { 0.0f, 0.0f, 0.0f };
+        candidates.assign(1, seed);
+
+        while (size_t(meshlet.indexCount) / 3 < maxTriangles)
+        {
+            const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            size_t best = candidates.size();
+            float bestScore = INFINITY;
+            size_t bestNewVertices = 0;
+            for (size_t c = 0; c < candidates.size(); ++c)
+            {
+                const GLuint t = candidates[c];
+                if (emitted[t])
+                    continue;
+                size_t newVertices = 0;
+                for (int k = 0; k < 3; ++k)
+                    newVertices += stamps[indices[t * 3 + k]] != stamp;
+                if (meshletVertices + newVertices > maxVertices)
+                    continue;
+
+                float spread = 0.0f;
+                if (axisLength > 0.0f)
+                {
+                    const float dot = (axis[0] * normals[t].n[0] + axis[1] * normals[t].n[1] + axis[2] * normals[t].n[2])
+                                    / axisLength;
+                    if (normals[t].valid && dot < MIN_GROWTH_DOT)
+                        continue;
+                    spread = 1.0f - dot;
+                }
+                const float score = newVertices + CONE_WEIGHT * spread;
+                if (score < bestScore)
+                {
+                    best = c;
+                    bestScore = score;
+                    bestNewVertices = newVertices;
+                }
+            }
+            if (best == candidates.size())
+                break;
+
+            const GLuint t = candidates[best];
+            candidates[best] = candidates.back();
+            candidates.pop_back();
+            emitted[t] = true;
+            for (int k = 0; k < 3; ++k)
+            {
+                const GLuint v = indices[t * 3 + k];
+                stamps[v] = stamp;
+                ordered.push_back(v);
+                axis[k] += normals[t].n[k];
+                for (GLuint neighbour : positionTriangles[positionIds[v]])
+                    if (!emitted[neighbour])
+                        candidates.push_back(neighbour);
+            }
+            meshletVertices += bestNewVertices;
+            meshlet.indexCount += 3;
+
+            // Drop the duplicates and the emitted triangles now and then
+            if (candidates.size() > 4 * maxTriangles)
+            {
+                std::sort(candidates.begin(), candidates.end());
+                candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+                candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                                [&emitted](GLuint c) { return bool(emitted[c]); }),
+                                 candidates.end());
+            }
+        }
+
+        meshlets.push_back(meshlet);
+    }
+
+    indices.swap(ordered);
+    for (Meshlet& meshlet : meshlets)
+        finishMeshlet(vertexData, vertexSize, indices, meshlet);
+}
+
+// The camera sees no front face when the direction to the meshlet stays
+// within 90 degrees minus the cone's half angle of the axis, for every point
+// of the bounding sphere (Kapoulkine, meshoptimizer)
+bool isMeshletBackFacing(const Meshlet& meshlet, const GLfloat cameraPosition[3])
+{
+    const float d[3] = { meshlet.center[0] - cameraPosition[0],
+                         meshlet.center[1] - cameraPosition[1],
+                         meshlet.center[2] - cameraPosition[2] };
+    const float distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    const float along = d[0] * meshlet.coneAxis[0] + d[1] * meshlet.coneAxis[1] + d[2] * meshlet.coneAxis[2];
+    return along >= meshlet.coneCutoff * distance + meshlet.radius;
+}
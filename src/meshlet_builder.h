@@ -0,0 +1,35 @@
+#ifndef MESHLET_BUILDER_H
+#define MESHLET_BUILDER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+// A contiguous range of a mesh's triangles, small enough to be culled on its
+// own. Positions are in the space of the .obj.
+struct Meshlet
+{
+    GLfloat center[3];
+    GLfloat radius;
+    // Every triangle normal is within the cone around coneAxis. coneCutoff is
+    // the sine of its half angle, 1 when the cone is too wide to ever cull.
+    GLfloat coneAxis[3];
+    GLfloat coneCutoff;
+    GLuint firstIndex; // relative to the indices reordered by buildMeshlets()
+    GLsizei indexCount;
+};
+
+// Groups neighbouring triangles with similar normals, a meshlet ending at
+// maxVertices unique vertices or maxTriangles triangles. The triangles are
+// reordered so each meshlet is a contiguous range, in the order of the
+// original index buffer's first triangles. vertexSize is in GLfloats, the
+// position coming first.
+void buildMeshlets(const std::vector<GLfloat>& vertexData, size_t vertexSize, std::vector<GLuint>& indices,
+                   std::vector<Meshlet>& meshlets, size_t maxVertices = 64, size_t maxTriangles = 124);
+
+// True when no triangle of the meshlet can face cameraPosition, given in the
+// space of the .obj
+bool isMeshletBackFacing(const Meshlet& meshlet, const GLfloat cameraPosition[3]);
+
+#endif // MESHLET_BUILDER_H
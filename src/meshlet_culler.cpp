@@ -0,0 +1,78 @@
+#include "meshlet_culler.h"
+
+MeshletCuller::MeshletCuller()
+: m_projView(1.0f)
+, m_cameraPosition(0.0f)
+, m_stats{}
+{
+}
+
+void MeshletCuller::begin(const glm::mat4& projView, const glm::vec3& cameraPosition)
+{
+    m_projView = projView;
+    m_cameraPosition = cameraPosition;
+}
+
+void MeshletCuller::cull(const Model& model, const glm::mat4& transform, std::vector<MeshRange>& ranges)
+{
+    const MeshRange& range = model.getRange();
+    const std::vector<Meshlet>& meshlets = model.getMeshlets();
+    if (meshlets.empty())
+    {
+        ranges.push_back(range);
+        return;
+    }
+
+    // Planes of the mvp are in object space, normalized there so the
+    // meshlet spheres are tested exactly whatever the scale
+    const glm::mat4 mvp = m_projView * transform;
+    glm::vec4 planes[6];
+    for (int i = 0; i < 3; ++i)
+    {
+        const glm::vec4 row(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]);
+        const glm::vec4 w(mvp[0][3], mvp[1][3], mvp[2][3], mvp[3][3]);
+        planes[i * 2] = w + row;
+        planes[i * 2 + 1] = w - row;
+    }
+    for (glm::vec4& plane : planes)
+    {
+        const float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+            plane = plane / length;
+    }
+    const glm::vec3 camera(glm::inverse(transform) * glm::vec4(m_cameraPosition, 1.0f));
+
+    const size_t firstRange = ranges.size();
+    for (const Meshlet& meshlet : meshlets)
+    {
+        m_stats.meshlets++;
+        m_stats.triangles += meshlet.indexCount / 3;
+
+        bool visible = !isMeshletBackFacing(meshlet, &camera[0]);
+        const glm::vec4 center(meshlet.center[0], meshlet.center[1], meshlet.center[2], 1.0f);
+        for (int p = 0; p < 6 && visible; ++p)
+            visible = glm::dot(planes[p], center) >= -meshlet.radius;
+        if (!visible)
+        {
+            m_stats.culled++;
+            m_stats.trianglesCulled += meshlet.indexCount / 3;
+            continue;
+        }
+
+        const GLuint firstIndex = range.firstIndex + meshlet.firstIndex;
+        if (ranges.size() > firstRange && ranges.back().firstIndex + ranges.back().indexCount == firstIndex)
+            ranges.back().indexCount += meshlet.indexCount;
+        else
+            ranges.push_back({ firstIndex, meshlet.indexCount, range.baseVertex });
+    }
+}
+
+void MeshletCuller::resetStats()
+{
+    m_stats = Stats{};
+}
+
+const MeshletCuller::Stats& MeshletCuller::getStats() const
+{
+    return m_stats;
+}
@@ -0,0 +1,44 @@
+#ifndef MESHLET_CULLER_H
+#define MESHLET_CULLER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "geometry_pool.h"
+#include "model.h"
+
+// Drops the meshlets of a model that face away from the camera or lie outside
+// the frustum, on the CPU. The tests run in the space of the .obj: the camera
+// and the planes are moved there once per object, the meshlets stay as built.
+class MeshletCuller
+{
+public:
+    struct Stats
+    {
+        int meshlets;
+        int culled;
+        int triangles;
+        int trianglesCulled;
+    };
+
+public:
+    MeshletCuller();
+
+    void begin(const glm::mat4& projView, const glm::vec3& cameraPosition);
+    // Appends the index ranges (see Model::getRange()) of the visible
+    // meshlets of the full mesh, consecutive ones merged. Models without
+    // meshlets add their full range.
+    void cull(const Model& model, const glm::mat4& transform, std::vector<MeshRange>& ranges);
+
+    // Accumulated by cull() until resetStats()
+    void resetStats();
+    const Stats& getStats() const;
+
+private:
+    glm::mat4 m_projView;
+    glm::vec3 m_cameraPosition;
+    Stats m_stats;
+};
+
+#endif // MESHLET_CULLER_H
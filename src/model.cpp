@@ -0,0 +1,256 @@
+#include "model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "obj_parser.h"
+#include "vertex_format.h"
+
+namespace
+{
+	const GLsizei VERTEX_SIZE = 8; // position (3), texCoords (2), normal (3)
+
+	// Share of the full mesh's triangles kept by each generated level
+	const std::vector<float> LOD_RATIOS = { 0.5f, 0.25f, 0.125f };
+}
+
+Model::Model(GeometryPool& pool, const char* path, unsigned int flags)
+: Model(pool, loadMesh(path, flags))
+{
+}
+
+Model::Model(GeometryPool& pool, const MeshData& mesh)
+: m_flags(mesh.flags)
+, m_boundingRadius(0.0f)
+, m_pool(pool)
+, m_drawcall(pool.getVao(), 0, GL_UNSIGNED_INT)
+{
+	if (pool.isQuantized() != bool(m_flags & QUANTIZE_VERTICES))
+	{
+		std::cout << "Vertex format of model " << mesh.path << " does not match its geometry pool" << std::endl;
+		// Nothing to draw, but getRange() and selectLod() still have a level
+		m_lodRanges.push_back({ 0, 0, 0 });
+		m_lodErrors.push_back(0.0f);
+		return;
+	}
+
+	addMesh(mesh.vertexData.data(), mesh.vertexCount, mesh.indices, mesh.lods);
+	setBounds(mesh.boundsMin, mesh.boundsMax, mesh.boundingRadius);
+	m_meshlets = mesh.meshlets;
+}
+
+MeshData Model::loadMesh(const char* path, unsigned int flags)
+{
+	MeshData mesh;
+	mesh.path = path;
+	mesh.flags = flags;
+	mesh.vertexCount = 0;
+	mesh.boundingRadius = 0.0f;
+	const GLsizei vertexStride = (flags & QUANTIZE_VERTICES) ? sizeof(QuantizedVertex) : VERTEX_SIZE * sizeof(GLfloat);
+
+	MeshCache cache(path, flags);
+	if (cache.load())
+	{
+		const unsigned char* vertices = static_cast<const unsigned char*>(cache.vertexData());
+		mesh.vertexData.assign(vertices, vertices + cache.vertexDataSize());
+		mesh.vertexCount = cache.vertexDataSize() / vertexStride;
+		mesh.indices.assign(cache.indexData(), cache.indexData() + cache.indexCount());
+		std::copy(cache.boundsMin(), cache.boundsMin() + 3, mesh.boundsMin);
+		std::copy(cache.boundsMax(), cache.boundsMax() + 3, mesh.boundsMax);
+		mesh.boundingRadius = cache.boundingRadius();
+		mesh.lods.assign(cache.lods(), cache.lods() + cache.lodCount());
+		mesh.meshlets.assign(cache.meshlets(), cache.meshlets() + cache.meshletCount());
+		return mesh;
+	}
+
+	std::vector<GLfloat> vertexData;
+	loadObj(path, vertexData, mesh.indices);
+	if (flags & OPTIMIZE_VERTEX_CACHE)
+		optimizeMesh(path, vertexData, mesh.indices);
+	if (flags & BUILD_MESHLETS)
+	{
+		buildMeshlets(vertexData, VERTEX_SIZE, mesh.indices, mesh.meshlets);
+		if (flags & OPTIMIZE_VERTEX_CACHE)
+			optimizeVertexFetch(vertexData, VERTEX_SIZE, mesh.indices);
+	}
+	mesh.lods.push_back({ 0, GLsizei(mesh.indices.size()), 0.0f });
+	if (flags & GENERATE_LODS)
+		generateLods(vertexData, mesh);
+
+	computeBounds(vertexData, VERTEX_SIZE, mesh.boundsMin, mesh.boundsMax);
+	mesh.boundingRadius = computeBoundingRadius(vertexData, VERTEX_SIZE, mesh.boundsMin, mesh.boundsMax);
+	mesh.vertexCount = vertexData.size() / VERTEX_SIZE;
+
+	const unsigned char* vertices = reinterpret_cast<const unsigned char*>(vertexData.data());
+	std::vector<QuantizedVertex> quantized;
+	if (flags & QUANTIZE_VERTICES)
+	{
+		quantizeVertices(vertexData, mesh.boundsMin, mesh.boundsMax, quantized);
+		vertices = reinterpret_cast<const unsigned char*>(quantized.data());
+	}
+	mesh.vertexData.assign(vertices, vertices + mesh.vertexCount * vertexStride);
+
+	if (!mesh.indices.empty())
+		cache.store(mesh.vertexData.data(), vertexStride, mesh.vertexCount, mesh.indices.data(), mesh.indices.size(),
+		            mesh.boundsMin, mesh.boundsMax, mesh.boundingRadius, mesh.lods.data(), mesh.lods.size(),
+		            mesh.meshlets.data(), mesh.meshlets.size());
+	return mesh;
+}
+
+void Model::loadObj(const char* path, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices)
+{
+	ObjParser parser;
+	parser.setWeldVertices(true);
+	if (!parser.parseFile(path, vertexData, indices))
+	{
+		std::cout << "Unable to load model " << path << std::endl;
+		return;
+	}
+
+	std::cout << path << ": " << parser.cornerCount() << " -> " << vertexData.size() / VERTEX_SIZE
+	          << " vertices after welding" << std::endl;
+}
+
+void Model::optimizeMesh(const char* path, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices)
+{
+	const size_t vertexCount = vertexData.size() / VERTEX_SIZE;
+	VertexCacheStats before = analyzeVertexCache(indices, vertexCount);
+
+	optimizeVertexCache(indices, vertexCount);
+	optimizeVertexFetch(vertexData, VERTEX_SIZE, indices);
+
+	VertexCacheStats after = analyzeVertexCache(indices, vertexData.size() / VERTEX_SIZE);
+	std::cout << path << ": ACMR " << before.acmr << " -> " << after.acmr
+	          << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+}
+
+// The levels are appended after the full mesh, they share its vertices
+void Model::generateLods(const std::vector<GLfloat>& vertexData, MeshData& mesh)
+{
+	const std::vector<GLuint> full = mesh.indices;
+	std::vector<SimplifiedLevel> levels = simplifyMesh(vertexData, VERTEX_SIZE, full, LOD_RATIOS);
+
+	for (SimplifiedLevel& level : levels)
+	{
+		if (mesh.flags & OPTIMIZE_VERTEX_CACHE)
+			optimizeVertexCache(level.indices, vertexData.size() / VERTEX_SIZE);
+		mesh.lods.push_back({ GLuint(mesh.indices.size()), GLsizei(level.indices.size()), level.error });
+		mesh.indices.insert(mesh.indices.end(), level.indices.begin(), level.indices.end());
+	}
+}
+
+void Model::addMesh(const void* vertexData, GLsizei vertexCount, const std::vector<GLuint>& indices,
+                    const std::vector<MeshLod>& lods)
+{
+	const MeshRange range = m_pool.add(vertexData, vertexCount, indices.data(), indices.size());
+	m_lodRanges.clear();
+	m_lodErrors.clear();
+	for (const MeshLod& lod : lods)
+	{
+		m_lodRanges.push_back({ range.firstIndex + lod.firstIndex, lod.indexCount, range.baseVertex });
+		m_lodErrors.push_back(lod.error);
+	}
+	if (m_lodRanges.empty())
+		m_lodRanges.push_back(range);
+
+	m_drawcall.setCount(m_lodRanges[0].indexCount);
+	m_drawcall.setRange(m_lodRanges[0].firstIndex, m_lodRanges[0].baseVertex);
+}
+
+void Model::setBounds(const GLfloat boundsMin[3], const GLfloat boundsMax[3], GLfloat boundingRadius)
+{
+	m_boundsMin = glm::vec3(boundsMin[0], boundsMin[1], boundsMin[2]);
+	m_boundsMax = glm::vec3(boundsMax[0], boundsMax[1], boundsMax[2]);
+	m_boundingRadius = boundingRadius;
+
+	m_vertexTransform = glm::mat4(1.0f);
+	if (m_flags & QUANTIZE_VERTICES)
+	{
+		// Undo the [0, 1] normalization done by quantizeVertices
+		glm::vec3 extent = m_boundsMax - m_boundsMin;
+		m_vertexTransform[0][0] = extent.x;
+		m_vertexTransform[1][1] = extent.y;
+		m_vertexTransform[2][2] = extent.z;
+		m_vertexTransform[3] = glm::vec4(m_boundsMin, 1.0f);
+	}
+}
+
+void Model::draw()
+{
+	m_drawcall.draw();
+}
+
+GeometryPool& Model::getPool() const
+{
+	return m_pool;
+}
+
+const MeshRange& Model::getRange(int lod) const
+{
+	return m_lodRanges[std::min(std::max(lod, 0), int(m_lodRanges.size()) - 1)];
+}
+
+int Model::getLodCount() const
+{
+	return m_lodRanges.size();
+}
+
+int Model::selectLod(const glm::mat4& transform, const glm::vec3& cameraPosition, GLfloat pixelsPerUnit,
+                     GLfloat maxPixelError) const
+{
+	float scale2 = 0.0f;
+	for (int c = 0; c < 3; ++c)
+		scale2 = std::max(scale2, glm::dot(glm::vec3(transform[c]), glm::vec3(transform[c])));
+	const float scale = std::sqrt(scale2);
+
+	// Distance to the closest point of the bounding sphere
+	const glm::vec3 center(transform * glm::vec4(getBoundingCenter(), 1.0f));
+	const float distance = glm::length(center - cameraPosition) - m_boundingRadius * scale;
+	if (distance <= 0.0f)
+		return 0;
+
+	for (int lod = m_lodErrors.size() - 1; lod > 0; --lod)
+		if (m_lodErrors[lod] * scale * pixelsPerUnit / distance <= maxPixelError)
+			return lod;
+	return 0;
+}
+
+const std::vector<Meshlet>& Model::getMeshlets() const
+{
+	return m_meshlets;
+}
+
+GLfloat Model::getLodPixelsPerUnit(const glm::mat4& projection, int viewportHeight)
+{
+	// projection[1][1] is 1 / tan(fovy / 2)
+	return projection[1][1] * viewportHeight * 0.5f;
+}
+
+const glm::mat4& Model::getVertexTransform() const
+{
+	return m_vertexTransform;
+}
+
+const glm::vec3& Model::getBoundsMin() const
+{
+	return m_boundsMin;
+}
+
+const glm::vec3& Model::getBoundsMax() const
+{
+	return m_boundsMax;
+}
+
+glm::vec3 Model::getBoundingCenter() const
+{
+	return (m_boundsMin + m_boundsMax) * 0.5f;
+}
+
+GLfloat Model::getBoundingRadius() const
+{
+	return m_boundingRadius;
+}
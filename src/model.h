@@ -1,24 +1,101 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <string>
 #include <vector>
 
-#include "buffer_object.h"
+#include <glm/glm.hpp>
+
 #include "draw_commands.h"
-#include "vertex_array_object.h"
+#include "geometry_pool.h"
+#include "meshlet_builder.h"
+
+// CPU side of a model, as it will be uploaded. Produced by Model::loadMesh,
+// which doesn't touch GL and may run on any thread.
+struct MeshData
+{
+	std::string path;
+	unsigned int flags;
+	std::vector<unsigned char> vertexData; // float or QuantizedVertex, see flags
+	GLsizei vertexCount;
+	std::vector<GLuint> indices; // every level of detail, one after the other
+	std::vector<MeshLod> lods;   // from the full mesh, at least one
+	std::vector<Meshlet> meshlets; // of the full mesh, empty without BUILD_MESHLETS
+	GLfloat boundsMin[3];
+	GLfloat boundsMax[3];
+	GLfloat boundingRadius; // around the center of the bounding box
+};
 
 class Model
 {
 public:
-	Model(const char* path);
+	enum Flags
+	{
+		// Reorder triangles then vertices for post-transform cache and fetch locality
+		OPTIMIZE_VERTEX_CACHE = 1 << 0,
+		// Store vertices as QuantizedVertex, 16 bytes instead of 32. Positions
+		// are 16 bit unsigned normalized inside the bounding box, texture
+		// coordinates half floats and normals 10:10:10 signed normalized.
+		// getVertexTransform() must be applied to the matrices transforming
+		// positions (mvp, modelView), but not to the normal matrix. The flag
+		// must match GeometryPool::isQuantized() of the pool.
+		QUANTIZE_VERTICES = 1 << 1,
+		// Add up to 3 simplified index ranges (1/2, 1/4, 1/8 of the triangles)
+		// sharing the vertices of the full mesh
+		GENERATE_LODS = 1 << 2,
+		// Split the full mesh in meshlets for MeshletCuller, its triangles are
+		// reordered meshlet by meshlet
+		BUILD_MESHLETS = 1 << 3,
+	};
+
+public:
+	// The mesh is added to pool, which must be uploaded before the first draw
+	Model(GeometryPool& pool, const char* path, unsigned int flags = 0);
+	Model(GeometryPool& pool, const MeshData& mesh);
 	void draw();
 
+	// Reads the mesh cache, or parses and processes the .obj and fills the cache
+	static MeshData loadMesh(const char* path, unsigned int flags = 0);
+
+	GeometryPool& getPool() const;
+	const MeshRange& getRange(int lod = 0) const;
+
+	int getLodCount() const;
+	// Coarsest level whose error covers at most maxPixelError pixels at the
+	// distance of the object. pixelsPerUnit: see getLodPixelsPerUnit()
+	int selectLod(const glm::mat4& transform, const glm::vec3& cameraPosition, GLfloat pixelsPerUnit,
+	              GLfloat maxPixelError = 1.0f) const;
+	// Size in pixels of one unit at distance one, from the projection matrix
+	static GLfloat getLodPixelsPerUnit(const glm::mat4& projection, int viewportHeight);
+
+	const std::vector<Meshlet>& getMeshlets() const;
+
+	const glm::mat4& getVertexTransform() const;
+
+	// Bounding box and sphere in the space of the .obj, whatever the flags
+	const glm::vec3& getBoundsMin() const;
+	const glm::vec3& getBoundsMax() const;
+	glm::vec3 getBoundingCenter() const;
+	GLfloat getBoundingRadius() const;
+
 private:
-	void loadObj(const char* path, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+	static void loadObj(const char* path, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+	static void optimizeMesh(const char* path, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+	static void generateLods(const std::vector<GLfloat>& vertexData, MeshData& mesh);
+	void addMesh(const void* vertexData, GLsizei vertexCount, const std::vector<GLuint>& indices,
+	             const std::vector<MeshLod>& lods);
+	void setBounds(const GLfloat boundsMin[3], const GLfloat boundsMax[3], GLfloat boundingRadius);
 
 private:
-	BufferObject m_vbo, m_ebo;
-	VertexArrayObject m_vao;
+	unsigned int m_flags;
+	glm::vec3 m_boundsMin, m_boundsMax;
+	GLfloat m_boundingRadius;
+	glm::mat4 m_vertexTransform;
+
+	GeometryPool& m_pool;
+	std::vector<MeshRange> m_lodRanges;
+	std::vector<GLfloat> m_lodErrors;
+	std::vector<Meshlet> m_meshlets;
 	DrawElementsCommand m_drawcall;
 };
 
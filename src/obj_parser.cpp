@@ -0,0 +1,376 @@
+#include "obj_parser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+#include "mapped_file.h"
+
+namespace
+{
+    const GLuint EMPTY_SLOT = ~0u;
+
+    inline bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t';
+    }
+
+    inline bool isEndOfLine(char c)
+    {
+        return c == '\n' || c == '\r';
+    }
+
+    inline const char* skipBlanks(const char* p, const char* end)
+    {
+        while (p < end && isBlank(*p))
+            ++p;
+        return p;
+    }
+
+    inline const char* nextLine(const char* p, const char* end)
+    {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        return eol ? eol + 1 : end;
+    }
+
+    inline const char* parseFloat(const char* p, const char* end, GLfloat& value)
+    {
+        p = skipBlanks(p, end);
+        if (p < end && *p == '+')
+            ++p;
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+        {
+            value = 0.0f;
+            while (p < end && !isBlank(*p) && !isEndOfLine(*p))
+                ++p;
+            return p;
+        }
+        return result.ptr;
+    }
+
+    // Face indices are plain decimal integers, a digit loop beats from_chars here
+    inline const char* parseInt(const char* p, const char* end, int& value, bool& ok)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        const char* start = p;
+        int result = 0;
+        while (p < end && unsigned(*p - '0') < 10)
+            result = result * 10 + (*p++ - '0');
+
+        ok = p != start;
+        value = negative ? -result : result;
+        return p;
+    }
+
+    // Same convention as objl::algorithm::getElement: 1-based, negative
+    // values are relative to the end of what has been read so far.
+    inline int resolveIndex(int index, size_t count)
+    {
+        int resolved = index < 0 ? int(count) + index : index - 1;
+        return (resolved >= 0 && size_t(resolved) < count) ? resolved : -1;
+    }
+}
+
+ObjParser::ObjParser()
+: m_weldVertices(false)
+, m_cornerCount(0)
+{
+}
+
+void ObjParser::setWeldVertices(bool weld)
+{
+    m_weldVertices = weld;
+}
+
+size_t ObjParser::cornerCount() const
+{
+    return m_cornerCount;
+}
+
+bool ObjParser::parse(const char* begin, const char* end, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices)
+{
+    m_cornerCount = 0;
+    m_positions.clear();
+    m_texCoords.clear();
+    m_normals.clear();
+
+    reserve(begin, end, vertexData, indices);
+
+    const char* p = begin;
+    while (p < end)
+    {
+        p = skipBlanks(p, end);
+        if (p + 1 < end && isBlank(p[1]))
+        {
+            if (p[0] == 'v')
+            {
+                GLfloat x, y, z;
+                p = parseFloat(p + 1, end, x);
+                p = parseFloat(p, end, y);
+                p = parseFloat(p, end, z);
+                m_positions.push_back(x);
+                m_positions.push_back(y);
+                m_positions.push_back(z);
+            }
+            else if (p[0] == 'f')
+            {
+                p = parseFace(p + 1, end, vertexData, indices);
+            }
+        }
+        else if (p + 2 < end && p[0] == 'v' && isBlank(p[2]))
+        {
+            if (p[1] == 't')
+            {
+                GLfloat u, v;
+                p = parseFloat(p + 2, end, u);
+                p = parseFloat(p, end, v);
+                m_texCoords.push_back(u);
+                m_texCoords.push_back(v);
+            }
+            else if (p[1] == 'n')
+            {
+                GLfloat x, y, z;
+                p = parseFloat(p + 2, end, x);
+                p = parseFloat(p, end, y);
+                p = parseFloat(p, end, z);
+                m_normals.push_back(x);
+                m_normals.push_back(y);
+                m_normals.push_back(z);
+            }
+        }
+        p = nextLine(p, end);
+    }
+
+    return !indices.empty();
+}
+
+bool ObjParser::parseFile(const char* path, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+        return false;
+    return parse(file.data(), file.data() + file.size(), vertexData, indices);
+}
+
+// Counts the element lines ahead of time so the parse never reallocates.
+void ObjParser::reserve(const char* begin, const char* end, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices)
+{
+    size_t positions = 0, texCoords = 0, normals = 0, faces = 0;
+    for (const char* p = begin; p < end; p = nextLine(p, end))
+    {
+        if (p + 2 >= end)
+            break;
+        if (p[0] == 'v')
+        {
+            if (isBlank(p[1]))
+                ++positions;
+            else if (p[1] == 't' && isBlank(p[2]))
+                ++texCoords;
+            else if (p[1] == 'n' && isBlank(p[2]))
+                ++normals;
+        }
+        else if (p[0] == 'f' && isBlank(p[1]))
+            ++faces;
+    }
+
+    m_positions.reserve(positions * 3);
+    m_texCoords.reserve(texCoords * 2);
+    m_normals.reserve(normals * 3);
+    indices.reserve(indices.size() + faces * 3);
+
+    if (m_weldVertices)
+    {
+        // A welded mesh has about as many vertices as it has positions
+        const size_t expected = std::max(positions, normals) + 16;
+        vertexData.reserve(vertexData.size() + expected * 8);
+        m_vertexKeys.assign(vertexData.size() / 8, Corner{ -1, -1, -1 });
+        m_vertexKeys.reserve(m_vertexKeys.size() + expected);
+        m_weldTable.clear();
+        rehash(expected * 2);
+    }
+    else
+    {
+        vertexData.reserve(vertexData.size() + faces * 3 * 8);
+    }
+}
+
+const char* ObjParser::parseFace(const char* p, const char* end, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices)
+{
+    m_face.clear();
+
+    bool missingNormal = false;
+    while (true)
+    {
+        p = skipBlanks(p, end);
+        if (p >= end || isEndOfLine(*p))
+            break;
+
+        Corner c = { -1, -1, -1 };
+        int value;
+        bool ok;
+        p = parseInt(p, end, value, ok);
+        if (!ok)
+            break;
+        c.position = resolveIndex(value, m_positions.size() / 3);
+
+        if (p < end && *p == '/')
+        {
+            p = parseInt(p + 1, end, value, ok);
+            if (ok)
+                c.texCoord = resolveIndex(value, m_texCoords.size() / 2);
+            if (p < end && *p == '/')
+            {
+                p = parseInt(p + 1, end, value, ok);
+                if (ok)
+                    c.normal = resolveIndex(value, m_normals.size() / 3);
+            }
+        }
+
+        if (c.position < 0)
+            return p;
+        missingNormal |= c.normal < 0;
+        m_face.push_back(c);
+    }
+
+    const size_t n = m_face.size();
+    if (n < 3)
+        return p;
+
+    // Like objl, a face with any corner lacking a normal gets the
+    // (unnormalized) normal of its first three positions on every corner.
+    GLfloat faceNormal[3];
+    if (missingNormal)
+    {
+        const GLfloat* p0 = &m_positions[m_face[0].position * 3];
+        const GLfloat* p1 = &m_positions[m_face[1].position * 3];
+        const GLfloat* p2 = &m_positions[m_face[2].position * 3];
+        GLfloat a[3] = { p0[0] - p1[0], p0[1] - p1[1], p0[2] - p1[2] };
+        GLfloat b[3] = { p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2] };
+        faceNormal[0] = a[1] * b[2] - a[2] * b[1];
+        faceNormal[1] = a[2] * b[0] - a[0] * b[2];
+        faceNormal[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    m_faceIndices.clear();
+    for (const Corner& c : m_face)
+    {
+        if (m_weldVertices && !missingNormal)
+        {
+            m_faceIndices.push_back(weldVertex(c, vertexData));
+            continue;
+        }
+
+        // Corners carrying a generated face normal are never shared
+        const GLuint index = vertexData.size() / 8;
+        vertexData.resize(vertexData.size() + 8);
+        emitVertex(c, missingNormal ? faceNormal : nullptr, &vertexData[index * 8]);
+        if (m_weldVertices)
+            m_vertexKeys.push_back({ -1, -1, -1 });
+        m_faceIndices.push_back(index);
+    }
+    m_cornerCount += n;
+
+    const GLuint* v = m_faceIndices.data();
+    const size_t first = indices.size();
+    indices.resize(first + (n - 2) * 3);
+    GLuint* tri = &indices[first];
+    if (n == 4)
+    {
+        // Same split as objl::Loader::VertexTriangluation for quads
+        tri[0] = v[0]; tri[1] = v[1]; tri[2] = v[3];
+        tri[3] = v[1]; tri[4] = v[2]; tri[5] = v[3];
+    }
+    else
+    {
+        for (size_t i = 1; i + 1 < n; ++i, tri += 3)
+        {
+            tri[0] = v[0];
+            tri[1] = v[i];
+            tri[2] = v[i + 1];
+        }
+    }
+    return p;
+}
+
+// Open addressing on the (v, vt, vn) triple; the table stores vertex
+// indices and the keys live in m_vertexKeys, one per emitted vertex.
+GLuint ObjParser::weldVertex(const Corner& c, std::vector<GLfloat>& vertexData)
+{
+    if ((m_vertexKeys.size() + 1) * 2 > m_weldTable.size())
+        rehash(m_weldTable.empty() ? 1024 : m_weldTable.size() * 2);
+
+    const size_t mask = m_weldTable.size() - 1;
+    size_t slot = hashCorner(c) & mask;
+    while (m_weldTable[slot] != EMPTY_SLOT)
+    {
+        const Corner& key = m_vertexKeys[m_weldTable[slot]];
+        if (key.position == c.position && key.texCoord == c.texCoord && key.normal == c.normal)
+            return m_weldTable[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    const GLuint index = vertexData.size() / 8;
+    vertexData.resize(vertexData.size() + 8);
+    emitVertex(c, nullptr, &vertexData[index * 8]);
+    m_vertexKeys.push_back(c);
+    m_weldTable[slot] = index;
+    return index;
+}
+
+void ObjParser::rehash(size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    m_weldTable.assign(size, EMPTY_SLOT);
+    const size_t mask = size - 1;
+    for (GLuint i = 0; i < m_vertexKeys.size(); ++i)
+    {
+        if (m_vertexKeys[i].position < 0)
+            continue;
+        size_t slot = hashCorner(m_vertexKeys[i]) & mask;
+        while (m_weldTable[slot] != EMPTY_SLOT)
+            slot = (slot + 1) & mask;
+        m_weldTable[slot] = i;
+    }
+}
+
+size_t ObjParser::hashCorner(const Corner& c)
+{
+    uint64_t h = uint32_t(c.position) * 0x9E3779B97F4A7C15ull;
+    h ^= uint32_t(c.texCoord) * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+    h ^= uint32_t(c.normal) * 0x165667B19E3779F9ull + (h >> 32);
+    return size_t(h ^ (h >> 31));
+}
+
+void ObjParser::emitVertex(const Corner& c, const GLfloat* normal, GLfloat* out)
+{
+    const GLfloat* position = &m_positions[c.position * 3];
+    out[0] = position[0];
+    out[1] = position[1];
+    out[2] = position[2];
+
+    if (c.texCoord >= 0)
+    {
+        const GLfloat* texCoord = &m_texCoords[c.texCoord * 2];
+        out[3] = texCoord[0];
+        out[4] = texCoord[1];
+    }
+    else
+    {
+        out[3] = 0.0f;
+        out[4] = 0.0f;
+    }
+
+    if (!normal)
+        normal = &m_normals[c.normal * 3];
+    out[5] = normal[0];
+    out[6] = normal[1];
+    out[7] = normal[2];
+}
@@ -0,0 +1,63 @@
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Wavefront .obj parser working directly on an in-memory byte range.
+//
+// Produces the interleaved position (3), texCoords (2), normal (3) layout
+// used by Model, with the same vertices and normals as objl::Loader. Numbers
+// are read in place with std::from_chars; the only allocations are the
+// growth of the output and of the scratch arrays, which are kept between
+// calls so a parser can be reused for several files.
+//
+// With welding enabled, face corners sharing the same (v, vt, vn) triple
+// are emitted once and referenced by index.
+class ObjParser
+{
+public:
+    ObjParser();
+
+    void setWeldVertices(bool weld);
+
+    // Number of face corners read by the last parse, i.e. the vertex count
+    // the mesh would have without welding.
+    size_t cornerCount() const;
+
+    bool parse(const char* begin, const char* end, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+    bool parseFile(const char* path, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+
+private:
+    struct Corner
+    {
+        int position;
+        int texCoord;
+        int normal;
+    };
+
+    void reserve(const char* begin, const char* end, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+    const char* parseFace(const char* p, const char* end, std::vector<GLfloat>& vertexData, std::vector<GLuint>& indices);
+    void emitVertex(const Corner& c, const GLfloat* normal, GLfloat* out);
+
+    GLuint weldVertex(const Corner& c, std::vector<GLfloat>& vertexData);
+    void rehash(size_t capacity);
+    static size_t hashCorner(const Corner& c);
+
+private:
+    bool m_weldVertices;
+    size_t m_cornerCount;
+
+    std::vector<GLfloat> m_positions;
+    std::vector<GLfloat> m_texCoords;
+    std::vector<GLfloat> m_normals;
+    std::vector<Corner> m_face;
+    std::vector<GLuint> m_faceIndices;
+
+    std::vector<Corner> m_vertexKeys;
+    std::vector<GLuint> m_weldTable;
+};
+
+#endif // OBJ_PARSER_H
@@ -0,0 +1,164 @@
+#include "occlusion_culler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gl_state.h"
+
+namespace
+{
+    // Unit cube, scaled to the bounding box of the models
+    const GLfloat BOX_VERTICES[8 * 3] = {
+        0, 0, 0,   1, 0, 0,   1, 1, 0,   0, 1, 0,
+        0, 0, 1,   1, 0, 1,   1, 1, 1,   0, 1, 1,
+    };
+    const GLubyte BOX_INDICES[36] = {
+        0, 2, 1,   0, 3, 2, // z = 0
+        4, 5, 6,   4, 6, 7, // z = 1
+        0, 1, 5,   0, 5, 4, // y = 0
+        3, 7, 6,   3, 6, 2, // y = 1
+        0, 4, 7,   0, 7, 3, // x = 0
+        1, 2, 6,   1, 6, 5, // x = 1
+    };
+
+    // Margin around the boxes for the camera test, the near plane would
+    // otherwise clip the faces of a box right in front of the camera
+    const float NEAR_MARGIN = 1.0f;
+}
+
+OcclusionCuller::OcclusionCuller(ShaderProgram& program, GLint mvpLocation)
+: m_program(program)
+, m_mvpLocation(mvpLocation)
+, m_boxBuffer(GL_ARRAY_BUFFER, sizeof(BOX_VERTICES), BOX_VERTICES, GL_STATIC_DRAW)
+, m_boxIndicesBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(BOX_INDICES), BOX_INDICES, GL_STATIC_DRAW)
+, m_boxVao()
+, m_boxDraw(m_boxVao, 36)
+, m_projView(1.0f)
+, m_cameraPosition(0.0f)
+, m_queriesUsed(0)
+, m_stats{}
+{
+    m_boxVao.specifyAttribute(m_boxBuffer, 0, 3, 3, 0);
+    m_boxVao.bind();
+    m_boxIndicesBuffer.bind();
+    m_boxVao.unbind();
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    if (!m_queries.empty())
+        glDeleteQueries(m_queries.size(), m_queries.data());
+}
+
+void OcclusionCuller::begin(const glm::mat4& projView, const glm::vec3& cameraPosition)
+{
+    readResults();
+    m_queriesUsed = 0;
+    m_stats.tested = 0;
+
+    m_projView = projView;
+    m_cameraPosition = cameraPosition;
+
+    m_program.use();
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    GLState::stencilMask(0x00);
+    GLState::setEnabled(GL_DEPTH_TEST, true);
+    GLState::setEnabled(GL_BLEND, false);
+    GLState::setEnabled(GL_CULL_FACE, true);
+}
+
+void OcclusionCuller::drawOccluder(Model& model, const glm::mat4& transform)
+{
+    glm::mat4 mvp = m_projView * transform * model.getVertexTransform();
+    glUniformMatrix4fv(m_mvpLocation, 1, GL_FALSE, &mvp[0][0]);
+    model.draw();
+}
+
+void OcclusionCuller::drawOccluder(DrawElementsCommand& draw, const glm::mat4& transform)
+{
+    glm::mat4 mvp = m_projView * transform;
+    glUniformMatrix4fv(m_mvpLocation, 1, GL_FALSE, &mvp[0][0]);
+    draw.draw();
+}
+
+GLuint OcclusionCuller::test(const Model& model, const glm::mat4* transforms, int count)
+{
+    const glm::vec3 boundsMin = model.getBoundsMin();
+    const glm::vec3 extent = model.getBoundsMax() - boundsMin;
+    glm::mat4 box(1.0f);
+    for (int k = 0; k < 3; ++k)
+        box[k][k] = std::max(extent[k], 1e-4f);
+    box[3] = glm::vec4(boundsMin, 1.0f);
+
+    for (int i = 0; i < count; ++i)
+    {
+        // The camera in the space of the box, where it is the unit cube
+        const glm::vec3 camera(glm::inverse(transforms[i] * box) * glm::vec4(m_cameraPosition, 1.0f));
+        const float margin = NEAR_MARGIN / std::min(std::min(extent.x, extent.y), extent.z);
+        if (camera.x > -margin && camera.y > -margin && camera.z > -margin
+            && camera.x < 1 + margin && camera.y < 1 + margin && camera.z < 1 + margin)
+            return 0;
+    }
+
+    if (m_stats.tested == 0)
+    {
+        // First box of the frame, the occluders are done
+        glDepthMask(GL_FALSE);
+        GLState::setEnabled(GL_CULL_FACE, false);
+    }
+    m_stats.tested++;
+
+    const GLuint query = nextQuery();
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, query);
+    for (int i = 0; i < count; ++i)
+    {
+        glm::mat4 mvp = m_projView * transforms[i] * box;
+        glUniformMatrix4fv(m_mvpLocation, 1, GL_FALSE, &mvp[0][0]);
+        m_boxDraw.draw();
+    }
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    return query;
+}
+
+void OcclusionCuller::end()
+{
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    GLState::stencilMask(0xFF);
+    GLState::setEnabled(GL_CULL_FACE, true);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+const OcclusionCuller::Stats& OcclusionCuller::getStats() const
+{
+    return m_stats;
+}
+
+GLuint OcclusionCuller::nextQuery()
+{
+    if (m_queriesUsed == m_queries.size())
+    {
+        GLuint query;
+        glGenQueries(1, &query);
+        m_queries.push_back(query);
+    }
+    return m_queries[m_queriesUsed++];
+}
+
+// Counts the hidden objects of the previous frame without waiting, a result
+// not yet available is counted as visible
+void OcclusionCuller::readResults()
+{
+    m_stats.hidden = 0;
+    for (size_t i = 0; i < m_queriesUsed; ++i)
+    {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+        GLuint anySamples = GL_TRUE;
+        glGetQueryObjectuiv(m_queries[i], GL_QUERY_RESULT, &anySamples);
+        if (!anySamples)
+            m_stats.hidden++;
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "buffer_object.h"
+#include "draw_commands.h"
+#include "model.h"
+#include "shader_program.h"
+#include "vertex_array_object.h"
+
+// Occlusion pass run before a scene: the big occluders are drawn in the
+// depth buffer only, then the bounding boxes of the other objects are
+// rasterized against it inside GL_ANY_SAMPLES_PASSED queries. The objects are
+// then drawn with glBeginConditionalRender on their query (see RenderItem),
+// so the GPU skips the draws whose boxes were entirely hidden, without the
+// CPU waiting for the results. end() clears the depth for the real pass.
+class OcclusionCuller
+{
+public:
+    struct Stats
+    {
+        int tested;
+        int hidden; // results of the previous frame, as they become available
+    };
+
+public:
+    // program draws positions at location 0 with an mvp uniform
+    OcclusionCuller(ShaderProgram& program, GLint mvpLocation);
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // Depth only from here to end()
+    void begin(const glm::mat4& projView, const glm::vec3& cameraPosition);
+    void drawOccluder(Model& model, const glm::mat4& transform);
+    void drawOccluder(DrawElementsCommand& draw, const glm::mat4& transform);
+
+    // Returns the query telling if any of the count instances of model may be
+    // visible, or 0 when the object must be drawn unconditionally (the camera
+    // is inside one of the boxes, which then cannot be rasterized)
+    GLuint test(const Model& model, const glm::mat4* transforms, int count = 1);
+
+    // Restores the masks and clears the depth buffer
+    void end();
+
+    const Stats& getStats() const;
+
+private:
+    GLuint nextQuery();
+    void readResults();
+
+private:
+    ShaderProgram& m_program;
+    GLint m_mvpLocation;
+
+    BufferObject m_boxBuffer;
+    BufferObject m_boxIndicesBuffer;
+    VertexArrayObject m_boxVao;
+    DrawElementsCommand m_boxDraw;
+
+    glm::mat4 m_projView;
+    glm::vec3 m_cameraPosition;
+
+    // Reused every frame, in order
+    std::vector<GLuint> m_queries;
+    size_t m_queriesUsed;
+
+    Stats m_stats;
+};
+
+#endif // OCCLUSION_CULLER_H
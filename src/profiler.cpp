@@ -0,0 +1,224 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "imgui/imgui.h"
+
+Profiler::Profiler()
+: m_currentFrame(0)
+, m_active(false)
+, m_activeSection(0)
+{
+}
+
+Profiler::~Profiler()
+{
+    for (FrameSlot& slot : m_frames)
+        if (!slot.queries.empty())
+            glDeleteQueries(slot.queries.size(), slot.queries.data());
+}
+
+void Profiler::beginFrame()
+{
+    if (m_active)
+        end();
+
+    // The oldest slot was issued FRAME_LATENCY - 1 frames ago
+    m_currentFrame = (m_currentFrame + 1) % FRAME_LATENCY;
+    FrameSlot& slot = m_frames[m_currentFrame];
+    collect(slot);
+    slot.samples.clear();
+}
+
+void Profiler::begin(const char* name)
+{
+    if (m_active)
+    {
+        std::cout << "Profiler: section \"" << name << "\" started inside \""
+                  << m_sections[m_activeSection].name << "\", sections cannot nest" << std::endl;
+        end();
+    }
+
+    FrameSlot& slot = m_frames[m_currentFrame];
+    if (slot.samples.size() == slot.queries.size())
+    {
+        GLuint query;
+        glGenQueries(1, &query);
+        slot.queries.push_back(query);
+    }
+
+    Sample sample;
+    sample.section = findSection(name);
+    sample.query = slot.queries[slot.samples.size()];
+    sample.cpuTime = 0.0;
+    slot.samples.push_back(sample);
+
+    glBeginQuery(GL_TIME_ELAPSED, sample.query);
+    m_active = true;
+    m_activeSection = sample.section;
+    m_activeStart = std::chrono::high_resolution_clock::now();
+}
+
+void Profiler::end()
+{
+    if (!m_active)
+        return;
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - m_activeStart;
+    glEndQuery(GL_TIME_ELAPSED);
+    m_frames[m_currentFrame].samples.back().cpuTime = elapsed.count();
+    m_active = false;
+}
+
+void Profiler::collect(FrameSlot& slot)
+{
+    if (slot.samples.empty())
+        return;
+
+    // Results of a frame become available in order, checking the last query is enough
+    GLint available = 0;
+    glGetQueryObjectiv(slot.samples.back().query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return;
+
+    for (Section& section : m_sections)
+        section.seen = false;
+
+    for (const Sample& sample : slot.samples)
+    {
+        GLuint64 gpuTime = 0;
+        glGetQueryObjectui64v(sample.query, GL_QUERY_RESULT, &gpuTime);
+
+        Section& section = m_sections[sample.section];
+        float gpu = gpuTime / 1e6f;
+        float cpu = float(sample.cpuTime);
+        if (section.seen)
+        {
+            // Several times in a frame, accumulated
+            int last = (section.next + HISTORY_SIZE - 1) % HISTORY_SIZE;
+            section.gpuHistory[last] += gpu;
+            section.cpuHistory[last] += cpu;
+            continue;
+        }
+        section.gpuHistory[section.next] = gpu;
+        section.cpuHistory[section.next] = cpu;
+        section.next = (section.next + 1) % HISTORY_SIZE;
+        section.count = std::min(section.count + 1, HISTORY_SIZE);
+        section.seen = true;
+    }
+}
+
+size_t Profiler::findSection(const char* name)
+{
+    for (size_t i = 0; i < m_sections.size(); i++)
+        if (m_sections[i].name == name)
+            return i;
+
+    Section section;
+    section.name = name;
+    section.count = 0;
+    section.next = 0;
+    section.seen = false;
+    m_sections.push_back(section);
+    return m_sections.size() - 1;
+}
+
+Profiler::Stats Profiler::computeStats(const float* history, int count)
+{
+    Stats stats = { 0.0f, 0.0f, 0.0f };
+    if (count == 0)
+        return stats;
+
+    stats.min = stats.max = history[0];
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        stats.min = std::min(stats.min, history[i]);
+        stats.max = std::max(stats.max, history[i]);
+        sum += history[i];
+    }
+    stats.avg = sum / count;
+    return stats;
+}
+
+void Profiler::drawPanel()
+{
+    ImGui::SetNextWindowPos(ImVec2(420, 10), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler");
+
+    // Only the sections of the last collected frame
+    std::vector<const Section*> visible;
+    for (const Section& section : m_sections)
+        if (section.seen && section.count > 0)
+            visible.push_back(&section);
+
+    if (ImGui::BeginTable("sections", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+    {
+        const char* headers[] = { "Section", "GPU avg", "min", "max", "CPU avg", "min", "max" };
+        for (const char* header : headers)
+            ImGui::TableSetupColumn(header);
+        ImGui::TableHeadersRow();
+
+        for (const Section* section : visible)
+        {
+            Stats gpu = computeStats(section->gpuHistory, section->count);
+            Stats cpu = computeStats(section->cpuHistory, section->count);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(section->name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", gpu.avg);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", gpu.min);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", gpu.max);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", cpu.avg);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", cpu.min);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", cpu.max);
+        }
+        ImGui::EndTable();
+    }
+
+    // Average GPU time of each section, laid end to end, against a 60 Hz frame
+    float total = 0.0f;
+    std::vector<float> averages;
+    for (const Section* section : visible)
+    {
+        averages.push_back(computeStats(section->gpuHistory, section->count).avg);
+        total += averages.back();
+    }
+    const float scale = std::max(total, 1000.0f / 60.0f);
+
+    const float width = ImGui::GetContentRegionAvail().x;
+    const float height = ImGui::GetTextLineHeightWithSpacing();
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + height), IM_COL32(40, 40, 40, 255));
+
+    float x = origin.x;
+    for (size_t i = 0; i < visible.size(); i++)
+    {
+        const float w = averages[i] / scale * width;
+        const ImU32 color = ImColor::HSV(i * 0.13f, 0.6f, 0.8f);
+        ImVec2 min(x, origin.y), max(x + w, origin.y + height);
+        drawList->AddRectFilled(min, max, color);
+        if (w > ImGui::CalcTextSize(visible[i]->name.c_str()).x + 4.0f)
+            drawList->AddText(ImVec2(x + 2.0f, origin.y), IM_COL32(0, 0, 0, 255), visible[i]->name.c_str());
+        if (ImGui::IsMouseHoveringRect(min, max))
+            ImGui::SetTooltip("%s: %.3f ms", visible[i]->name.c_str(), averages[i]);
+        x += w;
+    }
+    ImGui::Dummy(ImVec2(width, height));
+    ImGui::Text("GPU total %.3f ms", total);
+
+    ImGui::End();
+}
+
+
+ProfileScope::ProfileScope(Profiler& profiler, const char* name)
+: m_profiler(profiler)
+{
+    m_profiler.begin(name);
+}
+
+ProfileScope::~ProfileScope()
+{
+    m_profiler.end();
+}
@@ -0,0 +1,85 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Times named sections of a frame on the CPU and on the GPU (GL_TIME_ELAPSED).
+// Sections are sequential, they cannot nest since only one GL_TIME_ELAPSED
+// query may be active. Queries are read FRAME_LATENCY frames later and only
+// if available, so reading them never stalls.
+class Profiler
+{
+public:
+    static const int FRAME_LATENCY = 3;
+    static const int HISTORY_SIZE = 120;
+
+    struct Stats
+    {
+        float min, avg, max; // ms
+    };
+
+    Profiler();
+    ~Profiler();
+
+    void beginFrame();
+
+    void begin(const char* name);
+    void end();
+
+    // Panel with the rolling stats of each section and a bar of the frame
+    void drawPanel();
+
+private:
+    struct Sample
+    {
+        size_t section;
+        GLuint query;
+        double cpuTime; // ms
+    };
+
+    struct FrameSlot
+    {
+        std::vector<GLuint> queries;
+        std::vector<Sample> samples;
+    };
+
+    struct Section
+    {
+        std::string name;
+        float cpuHistory[HISTORY_SIZE];
+        float gpuHistory[HISTORY_SIZE];
+        int count;
+        int next;
+        bool seen; // in the last collected frame
+    };
+
+    void collect(FrameSlot& slot);
+    size_t findSection(const char* name);
+    static Stats computeStats(const float* history, int count);
+
+private:
+    FrameSlot m_frames[FRAME_LATENCY];
+    int m_currentFrame;
+    std::vector<Section> m_sections;
+
+    bool m_active;
+    size_t m_activeSection;
+    std::chrono::high_resolution_clock::time_point m_activeStart;
+};
+
+// Times the enclosing block
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler& profiler, const char* name);
+    ~ProfileScope();
+
+private:
+    Profiler& m_profiler;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,283 @@
+#include "render_queue.h"
+
+#include <algorithm>
+
+#include "gl_state.h"
+
+namespace
+{
+    // Key layout, most significant first
+    const int LAYER_SHIFT    = 56; // 8 bits
+    const int PROGRAM_SHIFT  = 48; // 8 bits
+    const int TEXTURE0_SHIFT = 36; // 12 bits
+    const int TEXTURE1_SHIFT = 24; // 12 bits
+    const int STATE_SHIFT    = 16; // 8 bits
+    const int MODEL_SHIFT    = 0;  // 16 bits
+
+    // Ids past their field only degrade the sort, groups compare the items
+    uint64_t field(size_t id, int bits, int shift)
+    {
+        return uint64_t(std::min<size_t>(id, (size_t(1) << bits) - 1)) << shift;
+    }
+
+    template <typename T>
+    size_t findOrAdd(std::vector<T>& ids, const T& value)
+    {
+        typename std::vector<T>::iterator it = std::find(ids.begin(), ids.end(), value);
+        if (it != ids.end())
+            return it - ids.begin();
+        ids.push_back(value);
+        return ids.size() - 1;
+    }
+
+    // GL calls needed to set a whole RenderState
+    const int STATE_CALLS = 6;
+
+    const void* texture0(const RenderItem& item)
+    {
+        return item.textureArray ? static_cast<const void*>(item.textureArray) : item.textures[0];
+    }
+}
+
+RenderState RenderState::defaults()
+{
+    return { GL_ALWAYS, 0, 0xFF, GL_KEEP, true, false, true };
+}
+
+bool RenderState::operator==(const RenderState& other) const
+{
+    return stencilFunc == other.stencilFunc && stencilRef == other.stencilRef
+        && stencilWriteMask == other.stencilWriteMask && stencilPassOp == other.stencilPassOp
+        && depthTest == other.depthTest && blend == other.blend && cullFace == other.cullFace;
+}
+
+bool RenderState::operator!=(const RenderState& other) const
+{
+    return !(*this == other);
+}
+
+bool RenderQueue::SortEntry::operator<(const SortEntry& other) const
+{
+    return key != other.key ? key < other.key : index < other.index;
+}
+
+RenderQueue::RenderQueue()
+: m_isMeshletCullingEnabled(true)
+, m_batchesUsed(0)
+, m_currentState(RenderState::defaults())
+, m_stats{}
+, m_profiler(nullptr)
+, m_layerNames(nullptr)
+{
+}
+
+void RenderQueue::beginFrame()
+{
+    m_stats = Stats{};
+    m_meshletCuller.resetStats();
+    m_batchesUsed = 0;
+}
+
+void RenderQueue::setProfiler(Profiler* profiler, const char* const* layerNames)
+{
+    m_profiler = profiler;
+    m_layerNames = layerNames;
+}
+
+void RenderQueue::submit(const RenderItem& item)
+{
+    m_sorted.push_back({ makeKey(item), uint32_t(m_items.size()) });
+    m_items.push_back(item);
+}
+
+uint64_t RenderQueue::makeKey(const RenderItem& item)
+{
+    return field(item.layer, 8, LAYER_SHIFT)
+         | field(findOrAdd<const ShaderProgram*>(m_programIds, item.program), 8, PROGRAM_SHIFT)
+         | field(findOrAdd<const void*>(m_textureIds, texture0(item)), 12, TEXTURE0_SHIFT)
+         | field(findOrAdd<const void*>(m_textureIds, item.textures[1]), 12, TEXTURE1_SHIFT)
+         | field(findOrAdd(m_stateIds, item.state), 8, STATE_SHIFT)
+         | field(findOrAdd<const Model*>(m_modelIds, item.model), 16, MODEL_SHIFT);
+}
+
+void RenderQueue::setMeshletCullingEnabled(bool enabled)
+{
+    m_isMeshletCullingEnabled = enabled;
+}
+
+void RenderQueue::flush(const glm::mat4& projView, const glm::vec3& cameraPosition)
+{
+    m_meshletCuller.begin(projView, cameraPosition);
+    m_culler.begin(projView);
+    for (const RenderItem& item : m_items)
+        m_culler.add(*item.model, item.transform);
+    m_culler.cull();
+    const size_t submitted = m_sorted.size();
+    m_sorted.erase(std::remove_if(m_sorted.begin(), m_sorted.end(),
+                                  [this](const SortEntry& entry) { return !m_culler.isVisible(entry.index); }),
+                   m_sorted.end());
+    m_stats.culled += submitted - m_sorted.size();
+
+    std::sort(m_sorted.begin(), m_sorted.end());
+
+    // Nothing is known about the GL state before the first item
+    ShaderProgram* currentProgram = nullptr;
+    const void* currentTextures[2] = { nullptr, nullptr };
+    bool stateKnown = false;
+    const int changesBefore = m_stats.programChanges + m_stats.textureChanges + m_stats.stateChanges;
+    int changesInline = 0;
+
+    const RenderItem* group = nullptr;
+    DrawBatch* batch = nullptr;
+    for (const SortEntry& entry : m_sorted)
+    {
+        const RenderItem& item = m_items[entry.index];
+        GeometryPool& pool = item.model->getPool();
+
+        const bool sameGroup = batch && item.layer == group->layer && item.program == group->program
+                            && texture0(item) == texture0(*group) && item.textures[1] == group->textures[1]
+                            && item.state == group->state && &pool == &batch->getPool()
+                            && item.occlusionQuery == group->occlusionQuery;
+        if (!sameGroup)
+        {
+            if (batch)
+                drawGroup(*batch, *group);
+            if (m_profiler && (!group || item.layer != group->layer))
+            {
+                m_profiler->end();
+                m_profiler->begin(m_layerNames[item.layer]);
+            }
+
+            if (!stateKnown || item.state != m_currentState)
+            {
+                applyState(item.state, !stateKnown);
+                stateKnown = true;
+            }
+            if (item.program != currentProgram)
+            {
+                item.program->use();
+                glUniformMatrix4fv(item.projViewLocation, 1, GL_FALSE, &projView[0][0]);
+                currentProgram = item.program;
+                m_stats.programChanges++;
+            }
+            if (item.textureArray && item.textureArray != currentTextures[0])
+            {
+                item.textureArray->use(0);
+                currentTextures[0] = item.textureArray;
+                m_stats.textureChanges++;
+            }
+            for (int unit = item.textureArray ? 1 : 0; unit < 2; unit++)
+            {
+                if (item.textures[unit] && item.textures[unit] != currentTextures[unit])
+                {
+                    item.textures[unit]->use(unit);
+                    currentTextures[unit] = item.textures[unit];
+                    m_stats.textureChanges++;
+                }
+            }
+
+            group = &item;
+            batch = &nextBatch(pool);
+        }
+        if (m_isMeshletCullingEnabled && item.lod == 0 && item.state.cullFace && !item.model->getMeshlets().empty())
+        {
+            m_meshletRanges.clear();
+            m_meshletCuller.cull(*item.model, item.transform, m_meshletRanges);
+            batch->add(*item.model, item.transform, m_meshletRanges, item.textureLayer);
+        }
+        else
+        {
+            batch->add(*item.model, item.transform, item.textureLayer, item.lod);
+        }
+
+        m_stats.items++;
+        changesInline += 1 + STATE_CALLS + (texture0(item) != nullptr) + (item.textures[1] != nullptr);
+    }
+    if (batch)
+        drawGroup(*batch, *group);
+    if (m_profiler)
+        m_profiler->end();
+    if (stateKnown)
+        applyState(RenderState::defaults(), false);
+
+    const int changes = m_stats.programChanges + m_stats.textureChanges + m_stats.stateChanges - changesBefore;
+    m_stats.changesAvoided += changesInline - changes;
+
+    m_items.clear();
+    m_sorted.clear();
+    m_programIds.clear();
+    m_textureIds.clear();
+    m_stateIds.clear();
+    m_modelIds.clear();
+}
+
+void RenderQueue::applyState(const RenderState& state, bool force)
+{
+    if (force || state.stencilFunc != m_currentState.stencilFunc || state.stencilRef != m_currentState.stencilRef)
+    {
+        GLState::stencilFunc(state.stencilFunc, state.stencilRef, 0xFF);
+        m_stats.stateChanges++;
+    }
+    if (force || state.stencilPassOp != m_currentState.stencilPassOp)
+    {
+        GLState::stencilOp(GL_KEEP, GL_KEEP, state.stencilPassOp);
+        m_stats.stateChanges++;
+    }
+    if (force || state.stencilWriteMask != m_currentState.stencilWriteMask)
+    {
+        GLState::stencilMask(state.stencilWriteMask);
+        m_stats.stateChanges++;
+    }
+    if (force || state.depthTest != m_currentState.depthTest)
+    {
+        GLState::setEnabled(GL_DEPTH_TEST, state.depthTest);
+        m_stats.stateChanges++;
+    }
+    if (force || state.blend != m_currentState.blend)
+    {
+        GLState::setEnabled(GL_BLEND, state.blend);
+        if (state.blend)
+            GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        m_stats.stateChanges++;
+    }
+    if (force || state.cullFace != m_currentState.cullFace)
+    {
+        GLState::setEnabled(GL_CULL_FACE, state.cullFace);
+        m_stats.stateChanges++;
+    }
+    m_currentState = state;
+}
+
+DrawBatch& RenderQueue::nextBatch(GeometryPool& pool)
+{
+    // One batch per group over the whole frame, so a buffer is never
+    // rewritten while a previous draw of the frame may still read it
+    if (m_batchesUsed == m_batches.size())
+        m_batches.emplace_back(new DrawBatch(pool));
+    else if (&m_batches[m_batchesUsed]->getPool() != &pool)
+        m_batches[m_batchesUsed].reset(new DrawBatch(pool));
+
+    DrawBatch& batch = *m_batches[m_batchesUsed++];
+    batch.clear();
+    return batch;
+}
+
+void RenderQueue::drawGroup(DrawBatch& batch, const RenderItem& group)
+{
+    if (group.occlusionQuery)
+        glBeginConditionalRender(group.occlusionQuery, GL_QUERY_WAIT);
+    batch.draw();
+    if (group.occlusionQuery)
+        glEndConditionalRender();
+    m_stats.drawCalls++;
+}
+
+const RenderQueue::Stats& RenderQueue::getStats() const
+{
+    return m_stats;
+}
+
+const MeshletCuller::Stats& RenderQueue::getMeshletStats() const
+{
+    return m_meshletCuller.getStats();
+}
@@ -0,0 +1,139 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "draw_batch.h"
+#include "frustum_culler.h"
+#include "meshlet_culler.h"
+#include "model.h"
+#include "profiler.h"
+#include "shader_program.h"
+#include "texture.h"
+#include "texture_array.h"
+
+// Fixed function state of an item. The stencil read mask is always 0xFF and
+// only the depth pass operation is configurable (stencil/depth fail keep).
+struct RenderState
+{
+    GLenum stencilFunc;
+    GLint stencilRef;
+    GLuint stencilWriteMask;
+    GLenum stencilPassOp;
+    bool depthTest;
+    bool blend; // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+    bool cullFace;
+
+    // The state main() sets up, also restored at the end of a flush
+    static RenderState defaults();
+
+    bool operator==(const RenderState& other) const;
+    bool operator!=(const RenderState& other) const;
+};
+
+struct RenderItem
+{
+    // Items are executed by increasing layer, layers keep ordering
+    // constraints (stencil, blending) while the rest is sorted freely
+    unsigned int layer;
+    // The program reads its projView uniform and a per-instance model matrix
+    // (see DrawBatch)
+    ShaderProgram* program;
+    GLint projViewLocation;
+    Texture2D* textures[2]; // units 0 and 1, nullptr for unused
+    // Bound on unit 0 instead of textures[0] when set. Items using different
+    // layers of the same array still share a draw.
+    TextureArray* textureArray;
+    GLfloat textureLayer;
+    RenderState state;
+    const Model* model;
+    int lod; // see Model::selectLod()
+    glm::mat4 transform;
+    // Drawn under glBeginConditionalRender when not 0 (see OcclusionCuller),
+    // only items sharing the query share a draw
+    GLuint occlusionQuery;
+};
+
+// Collects the draws of a scene and executes them sorted by a packed 64 bit
+// key (layer, program, textures, state, model), so each change happens once
+// per group. Consecutive items of a group become one multi draw indirect.
+// Items outside the frustum of projView are dropped before sorting. With
+// meshlet culling, only the visible meshlets of the full mesh of items culling
+// back faces are drawn.
+class RenderQueue
+{
+public:
+    struct Stats
+    {
+        int items;
+        int culled;
+        int drawCalls;
+        int programChanges;
+        int textureChanges;
+        int stateChanges;
+        // Compared to setting everything for every item, as inline code does
+        int changesAvoided;
+    };
+
+public:
+    RenderQueue();
+
+    // Resets the stats and recycles the batches of the previous frame
+    void beginFrame();
+
+    // Times each layer as a section named layerNames[layer]
+    void setProfiler(Profiler* profiler, const char* const* layerNames);
+
+    void setMeshletCullingEnabled(bool enabled);
+
+    void submit(const RenderItem& item);
+    // Executes and clears the submitted items
+    void flush(const glm::mat4& projView, const glm::vec3& cameraPosition);
+
+    const Stats& getStats() const;
+    const MeshletCuller::Stats& getMeshletStats() const;
+
+private:
+    uint64_t makeKey(const RenderItem& item);
+    // force: the current GL state is unknown, set every field
+    void applyState(const RenderState& state, bool force);
+    DrawBatch& nextBatch(GeometryPool& pool);
+    void drawGroup(DrawBatch& batch, const RenderItem& group);
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t index;
+        bool operator<(const SortEntry& other) const;
+    };
+
+    std::vector<RenderItem> m_items;
+    std::vector<SortEntry> m_sorted;
+    FrustumCuller m_culler;
+    MeshletCuller m_meshletCuller;
+    bool m_isMeshletCullingEnabled;
+    std::vector<MeshRange> m_meshletRanges;
+
+    // Small ids packed in the key, assigned in submission order
+    std::vector<const ShaderProgram*> m_programIds;
+    std::vector<const void*> m_textureIds; // Texture2D or TextureArray
+    std::vector<RenderState> m_stateIds;
+    std::vector<const Model*> m_modelIds;
+
+    std::vector<std::unique_ptr<DrawBatch>> m_batches;
+    size_t m_batchesUsed;
+
+    RenderState m_currentState;
+    Stats m_stats;
+
+    Profiler* m_profiler;
+    const char* const* m_layerNames;
+};
+
+#endif // RENDER_QUEUE_H
@@ -3,17 +3,26 @@
 #include "utils.h"
 
 #include "shader_object.h"
+#include "bindless_texture_table.h"
+#include "clustered_lights.h"
 
 #include <iostream>
 
 // Rien à faire ici, modification au besoin, mais ne devrait pas être le cas
 
 Resources::Resources()
-: texture("Texture")
+: textureStreamer(assets)
+, texture("Texture")
+, textureArrayInstanced("TextureArrayInstanced")
+, textureBindlessInstanced("TextureBindlessInstanced")
 , simpleColor("SimpleColor")
+, simpleColorInstanced("SimpleColorInstanced")
 , phong("Phong")
 , gouraud("Gouraud")
 , flat("Flat")
+, gbuffer("GBuffer")
+, deferred("Deferred")
+, clustered("Clustered")
 {
     ShaderObject vertexT("texture.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/texture.vs.glsl").c_str());
     ShaderObject fragmentT("texture.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/texture.fs.glsl").c_str());
@@ -22,6 +31,23 @@ Resources::Resources()
     texture.link();
     mvpLocationTexture = texture.getUniformLoc("mvp");
     
+    ShaderObject vertexTA("textureArrayInstanced.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/textureArrayInstanced.vs.glsl").c_str());
+    ShaderObject fragmentTA("textureArray.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/textureArray.fs.glsl").c_str());
+    textureArrayInstanced.attachShaderObject(vertexTA);
+    textureArrayInstanced.attachShaderObject(fragmentTA);
+    textureArrayInstanced.link();
+    projViewLocationTextureArrayInstanced = textureArrayInstanced.getUniformLoc("projView");
+    
+    projViewLocationTextureBindlessInstanced = -1;
+    if (BindlessTextureTable::isSupported())
+    {
+        ShaderObject fragmentTB("textureBindless.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/textureBindless.fs.glsl").c_str());
+        textureBindlessInstanced.attachShaderObject(vertexTA);
+        textureBindlessInstanced.attachShaderObject(fragmentTB);
+        textureBindlessInstanced.link();
+        projViewLocationTextureBindlessInstanced = textureBindlessInstanced.getUniformLoc("projView");
+    }
+    
     ShaderObject vertexS("simpleColor.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/simpleColor.vs.glsl").c_str());
     ShaderObject fragmentS("simpleColor.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/simpleColor.fs.glsl").c_str());
     simpleColor.attachShaderObject(vertexS);
@@ -29,6 +55,13 @@ Resources::Resources()
     simpleColor.link();
     mvpLocationSimpleColor = simpleColor.getUniformLoc("mvp");
     
+    ShaderObject vertexSI("simpleColorInstanced.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/simpleColorInstanced.vs.glsl").c_str());
+    ShaderObject fragmentSI("simpleColor.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/simpleColor.fs.glsl").c_str());
+    simpleColorInstanced.attachShaderObject(vertexSI);
+    simpleColorInstanced.attachShaderObject(fragmentSI);
+    simpleColorInstanced.link();
+    projViewLocationSimpleColorInstanced = simpleColorInstanced.getUniformLoc("projView");
+    
     ShaderObject vertex("phong.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/phong.vs.glsl").c_str());
     ShaderObject fragment("phong.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/phong.fs.glsl").c_str());
     phong.attachShaderObject(vertex);
@@ -39,10 +72,8 @@ Resources::Resources()
     glUniform1i(phong.getUniformLoc("diffuseSampler"), 0);
     glUniform1i(phong.getUniformLoc("specularSampler"), 1);
 
-    mvpLocationPhong = phong.getUniformLoc("mvp");
-    modelViewLocationPhong = phong.getUniformLoc("modelView");
     viewLocationPhong = phong.getUniformLoc("view");
-    normalLocationPhong = phong.getUniformLoc("normalMatrix");
+    objectIndexLocationPhong = phong.getUniformLoc("objectIndex");
     
     ShaderObject vertexG("gouraud.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/gouraud.vs.glsl").c_str());    
     ShaderObject fragmentG("gouraud.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/gouraud.fs.glsl").c_str());
@@ -54,10 +85,8 @@ Resources::Resources()
     glUniform1i(gouraud.getUniformLoc("diffuseSampler"), 0);
     glUniform1i(gouraud.getUniformLoc("specularSampler"), 1);
         
-    mvpLocationGouraud = gouraud.getUniformLoc("mvp");
-    modelViewLocationGouraud = gouraud.getUniformLoc("modelView");
     viewLocationGouraud = gouraud.getUniformLoc("view");
-    normalLocationGouraud = gouraud.getUniformLoc("normalMatrix");
+    objectIndexLocationGouraud = gouraud.getUniformLoc("objectIndex");
 
     ShaderObject vertexF("flat.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/flat.vs.glsl").c_str());
     ShaderObject geomF("flat.gs.glsl", GL_GEOMETRY_SHADER, readFile("shaders/flat.gs.glsl").c_str());
@@ -71,9 +100,62 @@ Resources::Resources()
     glUniform1i(flat.getUniformLoc("diffuseSampler"), 0);
     glUniform1i(flat.getUniformLoc("specularSampler"), 1);
     
-    mvpLocationFlat = flat.getUniformLoc("mvp");
-    modelViewLocationFlat = flat.getUniformLoc("modelView");
     viewLocationFlat = flat.getUniformLoc("view");
-    normalLocationFlat = flat.getUniformLoc("normalMatrix");
+    objectIndexLocationFlat = flat.getUniformLoc("objectIndex");
+
+    ShaderObject vertexGB("gbuffer.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/gbuffer.vs.glsl").c_str());
+    ShaderObject fragmentGB("gbuffer.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/gbuffer.fs.glsl").c_str());
+    gbuffer.attachShaderObject(vertexGB);
+    gbuffer.attachShaderObject(fragmentGB);
+    gbuffer.link();
+
+    gbuffer.use();
+    glUniform1i(gbuffer.getUniformLoc("diffuseSampler"), 0);
+    glUniform1i(gbuffer.getUniformLoc("specularSampler"), 1);
+
+    objectIndexLocationGBuffer = gbuffer.getUniformLoc("objectIndex");
+
+    ShaderObject vertexD("deferred.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/deferred.vs.glsl").c_str());
+    ShaderObject fragmentD("deferred.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/deferred.fs.glsl").c_str());
+    deferred.attachShaderObject(vertexD);
+    deferred.attachShaderObject(fragmentD);
+    deferred.link();
+
+    // Units of GBuffer::bindTextures(0)
+    deferred.use();
+    glUniform1i(deferred.getUniformLoc("albedoSampler"), 0);
+    glUniform1i(deferred.getUniformLoc("specularSampler"), 1);
+    glUniform1i(deferred.getUniformLoc("normalSampler"), 2);
+    glUniform1i(deferred.getUniformLoc("emissionSampler"), 3);
+    glUniform1i(deferred.getUniformLoc("depthSampler"), 4);
+
+    viewLocationDeferred = deferred.getUniformLoc("view");
+    invProjectionLocationDeferred = deferred.getUniformLoc("invProjection");
+
+    viewLocationClustered = -1;
+    objectIndexLocationClustered = -1;
+    viewportSizeLocationClustered = -1;
+    depthSliceScaleLocationClustered = -1;
+    depthSliceBiasLocationClustered = -1;
+    if (ClusteredLights::isSupported())
+    {
+        ShaderObject vertexC("clustered.vs.glsl", GL_VERTEX_SHADER, readFile("shaders/clustered.vs.glsl").c_str());
+        ShaderObject fragmentC("clustered.fs.glsl", GL_FRAGMENT_SHADER, readFile("shaders/clustered.fs.glsl").c_str());
+        clustered.attachShaderObject(vertexC);
+        clustered.attachShaderObject(fragmentC);
+        clustered.link();
+
+        clustered.use();
+        glUniform1i(clustered.getUniformLoc("diffuseSampler"), 0);
+        glUniform1i(clustered.getUniformLoc("specularSampler"), 1);
+        glUniform3i(clustered.getUniformLoc("clusterGrid"),
+                    ClusteredLights::GRID_X, ClusteredLights::GRID_Y, ClusteredLights::GRID_Z);
+
+        viewLocationClustered = clustered.getUniformLoc("view");
+        objectIndexLocationClustered = clustered.getUniformLoc("objectIndex");
+        viewportSizeLocationClustered = clustered.getUniformLoc("viewportSize");
+        depthSliceScaleLocationClustered = clustered.getUniformLoc("depthSliceScale");
+        depthSliceBiasLocationClustered = clustered.getUniformLoc("depthSliceBias");
+    }
 }
 
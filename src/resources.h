@@ -3,7 +3,10 @@
 
 #include "shader_program.h"
 
+#include "asset_loader.h"
 #include "buffer_object.h"
+#include "profiler.h"
+#include "texture_streamer.h"
 
 class Resources
 {
@@ -12,32 +15,56 @@ public:
     
     void initShaderProgram(ShaderProgram& program, const char* vertexSrcPath, const char* fragmentSrcPath);
     
+    AssetLoader assets;
+    TextureStreamer textureStreamer;
+    Profiler profiler;
+    
     // Shaders stencil
     
     ShaderProgram texture;
     GLint mvpLocationTexture;
     
+    ShaderProgram textureArrayInstanced;
+    GLint projViewLocationTextureArrayInstanced;
+    
+    // Only linked if BindlessTextureTable::isSupported()
+    ShaderProgram textureBindlessInstanced;
+    GLint projViewLocationTextureBindlessInstanced;
+    
     ShaderProgram simpleColor;
     GLint mvpLocationSimpleColor;
     
+    ShaderProgram simpleColorInstanced;
+    GLint projViewLocationSimpleColorInstanced;
+    
     // Shaders lighting
     ShaderProgram phong;
-    GLint mvpLocationPhong;
-    GLint modelViewLocationPhong;
     GLint viewLocationPhong;
-    GLint normalLocationPhong;
+    GLint objectIndexLocationPhong;
 
     ShaderProgram gouraud;
-    GLint mvpLocationGouraud;
-    GLint modelViewLocationGouraud;
     GLint viewLocationGouraud;
-    GLint normalLocationGouraud;
+    GLint objectIndexLocationGouraud;
 
     ShaderProgram flat;
-    GLint mvpLocationFlat;
-    GLint modelViewLocationFlat;
     GLint viewLocationFlat;
-    GLint normalLocationFlat;
+    GLint objectIndexLocationFlat;
+
+    // Deferred lighting: geometry pass into a GBuffer, then lighting pass
+    ShaderProgram gbuffer;
+    GLint objectIndexLocationGBuffer;
+
+    ShaderProgram deferred;
+    GLint viewLocationDeferred;
+    GLint invProjectionLocationDeferred;
+
+    // Clustered forward lighting, only linked if ClusteredLights::isSupported()
+    ShaderProgram clustered;
+    GLint viewLocationClustered;
+    GLint objectIndexLocationClustered;
+    GLint viewportSizeLocationClustered;
+    GLint depthSliceScaleLocationClustered;
+    GLint depthSliceBiasLocationClustered;
 };
 
 #endif // RESOURCES_H
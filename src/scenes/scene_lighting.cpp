@@ -1,35 +1,110 @@
 #include "scene_lighting.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "imgui/imgui.h"
 
+#include "gl_state.h"
 #include "utils.h"
 
 #include <iostream>
 
+namespace
+{
+    const char* const SUZANNE_PATH = "../models/suzanne.obj";
+    const char* const SPHERE_PATH = "../models/icosphere.obj";
+    const char* const CUBE_PATH = "../models/cube.obj";
+    const char* const SPOTLIGHT_PATH = "../models/spotlight.obj";
+
+    const char* const WHITE_TEXTURE_PATH = "../textures/white.png";
+    const char* const DIFFUSE_MAP_PATH = "../textures/metal_0029_color_1k.jpg";
+    const char* const SPECULAR_MAP_PATH = "../textures/metal_0029_metallic_1k.jpg";
+
+    const GLuint LIGHTING_BLOCK_BINDING = 0;
+    const GLuint OBJECT_BLOCK_BINDING = 1;
+    // The object, then one block per light gizmo
+    const int LIGHTING_BLOCKS_PER_FRAME = 4;
+
+    const int SHADING_DEFERRED = 3;
+    const int SHADING_CLUSTERED = 4;
+
+    // Shader storage bindings of clustered.fs.glsl
+    const GLuint LIGHT_BUFFER_BINDING = 0;
+    const GLuint CLUSTER_BUFFER_BINDING = 1;
+    const GLuint LIGHT_INDEX_BUFFER_BINDING = 2;
+
+    const int MAX_EXTRA_LIGHTS = 1024;
+    const float EXTRA_LIGHT_RANGE = 1.2f;
+
+    // objects[] of ObjectBlock: the object, then the light gizmos
+    const int OBJECT_INDEX = 0;
+    const int FIRST_LIGHT_INDEX = 1;
+
+    // Spread over a sphere around the object (golden angle spiral), each one
+    // aimed at the center, with a color going around the hue circle
+    void setExtraLights(ClusteredLights& lights, size_t first, int count)
+    {
+        const float GOLDEN_ANGLE = 2.39996323f;
+        const float TWO_PI = 6.28318531f;
+        for (int i = 0; i < count; ++i)
+        {
+            const float y = 1.0f - 2.0f * (i + 0.5f) / count;
+            const float ring = std::sqrt(1.0f - y * y);
+            const float angle = GOLDEN_ANGLE * i;
+            const glm::vec3 direction(ring * std::cos(angle), y, ring * std::sin(angle));
+            const float distance = 1.6f + 0.4f * std::sin(i * 0.37f);
+
+            const float hue = float(i) / count;
+            const glm::vec3 color = glm::vec3(0.5f) + 0.5f * glm::vec3(std::cos(TWO_PI * hue),
+                                                                       std::cos(TWO_PI * (hue - 1.0f / 3.0f)),
+                                                                       std::cos(TWO_PI * (hue - 2.0f / 3.0f)));
+            lights.setLight(first + i, direction * distance, EXTRA_LIGHT_RANGE, -direction, color * 0.6f, color * 0.3f);
+        }
+    }
+}
+
+void SceneLighting::requestAssets(AssetLoader& loader)
+{
+    loader.requestMesh(SUZANNE_PATH, Model::OPTIMIZE_VERTEX_CACHE);
+    loader.requestMesh(SPHERE_PATH, Model::OPTIMIZE_VERTEX_CACHE);
+    loader.requestMesh(CUBE_PATH, Model::OPTIMIZE_VERTEX_CACHE);
+    loader.requestMesh(SPOTLIGHT_PATH, Model::OPTIMIZE_VERTEX_CACHE);
+
+    loader.requestImage(WHITE_TEXTURE_PATH);
+    loader.requestImage(DIFFUSE_MAP_PATH);
+    loader.requestImage(SPECULAR_MAP_PATH);
+}
+
 SceneLighting::SceneLighting(Resources& res, bool& isMouseMotionEnabled)
 : Scene(res)
 , m_isMouseMotionEnabled(isMouseMotionEnabled)
 , m_cameraOrientation(0)
 
-, m_suzanne("../models/suzanne.obj")
-, m_sphere("../models/icosphere.obj")
-, m_cube("../models/cube.obj")
-, m_spotlight("../models/spotlight.obj")
+, m_geometry(false)
+, m_suzanne(m_geometry, res.assets.getMesh(SUZANNE_PATH, Model::OPTIMIZE_VERTEX_CACHE))
+, m_sphere(m_geometry, res.assets.getMesh(SPHERE_PATH, Model::OPTIMIZE_VERTEX_CACHE))
+, m_cube(m_geometry, res.assets.getMesh(CUBE_PATH, Model::OPTIMIZE_VERTEX_CACHE))
+, m_spotlight(m_geometry, res.assets.getMesh(SPOTLIGHT_PATH, Model::OPTIMIZE_VERTEX_CACHE))
 
-, m_whiteTexture("../textures/white.png")
-, m_diffuseMapTexture("../textures/metal_0029_color_1k.jpg")
-, m_specularMapTexture("../textures/metal_0029_metallic_1k.jpg")
+, m_whiteTexture(res.assets.getImage(WHITE_TEXTURE_PATH))
+, m_diffuseMapTexture()
+, m_specularMapTexture()
 
-, m_lightingData(nullptr, sizeof(m_lightModel) + sizeof(m_material) + sizeof(m_lights))
+, m_lightingData(LIGHTING_BLOCKS_PER_FRAME * sizeof(LightingBlock) + sizeof(ObjectData) * MAX_OBJECTS, LIGHTING_BLOCKS_PER_FRAME + 1)
 
 , m_currentModel(0)
 , m_currentShading(2)
 , m_menuVisible(true)
+
+, m_extraLightCount(256)
 {
+    m_geometry.upload();
+
     m_whiteTexture.setFiltering(GL_LINEAR);
     m_whiteTexture.setWrap(GL_CLAMP_TO_EDGE);
    
@@ -38,6 +113,10 @@ SceneLighting::SceneLighting(Resources& res, bool& isMouseMotionEnabled)
    
     m_specularMapTexture.setFiltering(GL_LINEAR);
     m_specularMapTexture.setWrap(GL_CLAMP_TO_EDGE);
+
+    // The 1k maps are streamed in, the placeholders are shown until then
+    res.textureStreamer.stream(m_diffuseMapTexture, DIFFUSE_MAP_PATH);
+    res.textureStreamer.stream(m_specularMapTexture, SPECULAR_MAP_PATH);
     
     m_lightModel =
     {
@@ -87,8 +166,18 @@ SceneLighting::SceneLighting(Resources& res, bool& isMouseMotionEnabled)
     orientation[1] = glm::vec2(45.0f, -45.0f);
     orientation[2] = glm::vec2(45.0f, 180.0f);
 
-    m_resources.phong.setUniformBlockBinding("LightingBlock", 0);
-    m_lightingData.setBindingIndex(0);
+    m_resources.phong.setUniformBlockBinding("LightingBlock", LIGHTING_BLOCK_BINDING);
+    m_resources.phong.setUniformBlockBinding("ObjectBlock", OBJECT_BLOCK_BINDING);
+    m_resources.gouraud.setUniformBlockBinding("ObjectBlock", OBJECT_BLOCK_BINDING);
+    m_resources.flat.setUniformBlockBinding("ObjectBlock", OBJECT_BLOCK_BINDING);
+    m_resources.gbuffer.setUniformBlockBinding("LightingBlock", LIGHTING_BLOCK_BINDING);
+    m_resources.gbuffer.setUniformBlockBinding("ObjectBlock", OBJECT_BLOCK_BINDING);
+    m_resources.deferred.setUniformBlockBinding("LightingBlock", LIGHTING_BLOCK_BINDING);
+    if (ClusteredLights::isSupported())
+    {
+        m_resources.clustered.setUniformBlockBinding("LightingBlock", LIGHTING_BLOCK_BINDING);
+        m_resources.clustered.setUniformBlockBinding("ObjectBlock", OBJECT_BLOCK_BINDING);
+    }
 }
 
 void SceneLighting::run(Window& w, double dt)
@@ -96,93 +185,175 @@ void SceneLighting::run(Window& w, double dt)
     updateInput(w, dt);
     
     drawMenu();
+    m_culler.resetStats();
 
-    GLintptr offset = 0;
-    m_lightingData.updateData(&m_material  , offset, sizeof(m_material));   offset += sizeof(m_material);
-    m_lightingData.updateData(m_lights     , offset, sizeof(m_lights));     offset += sizeof(m_lights);
-    m_lightingData.updateData(&m_lightModel, offset, sizeof(m_lightModel)); offset += sizeof(m_lightModel);
+    // The spot directions are in the block, the gizmos are placed first
+    glm::mat4 lightModels[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        lightModels[i] = glm::mat4(1.0f);
+        lightModels[i] = glm::translate(lightModels[i], glm::vec3(m_lights[i].position));
+        lightModels[i] = glm::rotate(lightModels[i], glm::radians(orientation[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
+        lightModels[i] = glm::rotate(lightModels[i], glm::radians(orientation[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
+        m_lights[i].spotDirection = lightModels[i] * glm::vec4(0, -1, 0, 0);
+    }
+
+    m_lightingData.beginFrame();
+    LightingBlock block;
+    block.material = m_material;
+    std::copy(m_lights, m_lights + 3, block.lights);
+    block.lightModel = m_lightModel;
+    m_lightingData.bindData(LIGHTING_BLOCK_BINDING, &block, sizeof(block));
     
     glm::mat4 projPersp = getProjectionMatrix(w);
     glm::mat4 view = getCameraThirdPerson();
-
-    glm::mat4 mvp;
     glm::mat4 projView = projPersp * view;
-    glm::mat4 modelView;
 
-    GLint mvpMatrixLocation = -1;
+    // All the matrices of the frame in one block, each draw only selects its index
+    m_transforms.clear();
+    m_transforms.add(glm::mat4(1.0f));
+    for (int i = 0; i < 3; ++i)
+        m_transforms.add(lightModels[i]);
+    ObjectData objects[MAX_OBJECTS] = {};
+    m_transforms.compute(projView, view, objects);
+
+    Model* models[] = { &m_sphere, &m_cube, &m_suzanne };
+    Model& model = *models[m_currentModel];
+    m_culler.begin(projView);
+    m_culler.add(model, glm::mat4(1.0f));
+    for (int i = 0; i < 3; ++i)
+        m_culler.add(m_spotlight, lightModels[i]);
+    m_culler.cull();
+    m_lightingData.bindData(OBJECT_BLOCK_BINDING, objects, sizeof(objects));
+
     GLint viewMatrixLocation = -1;
-    GLint modelViewMatrixLocation = -1;
-    GLint normalMatrixLocation = -1;
+    GLint objectIndexLocation = -1;
     
     switch (m_currentShading)
     {
     case 0: 
         m_resources.flat.use();
         viewMatrixLocation = m_resources.viewLocationFlat;
-        mvpMatrixLocation = m_resources.mvpLocationFlat;
-        modelViewMatrixLocation = m_resources.modelViewLocationFlat;
-        normalMatrixLocation = m_resources.normalLocationFlat;
+        objectIndexLocation = m_resources.objectIndexLocationFlat;
         break;
     case 1:
         m_resources.gouraud.use();
         viewMatrixLocation = m_resources.viewLocationGouraud;
-        mvpMatrixLocation = m_resources.mvpLocationGouraud;
-        modelViewMatrixLocation = m_resources.modelViewLocationGouraud;
-        normalMatrixLocation = m_resources.normalLocationGouraud;
+        objectIndexLocation = m_resources.objectIndexLocationGouraud;
         break;
     case 2: 
         m_resources.phong.use();
         viewMatrixLocation = m_resources.viewLocationPhong;
-        mvpMatrixLocation = m_resources.mvpLocationPhong;
-        modelViewMatrixLocation =  m_resources.modelViewLocationPhong;
-        normalMatrixLocation = m_resources.normalLocationPhong;
+        objectIndexLocation = m_resources.objectIndexLocationPhong;
+        break;
+    case SHADING_DEFERRED:
+        // Falls back to Phong if the G-buffer can't be created
+        if (!m_gbuffer.resize(w.getWidth(), w.getHeight()))
+        {
+            m_currentShading = 2;
+            m_resources.phong.use();
+            viewMatrixLocation = m_resources.viewLocationPhong;
+            objectIndexLocation = m_resources.objectIndexLocationPhong;
+            break;
+        }
+        m_gbuffer.begin();
+        m_resources.gbuffer.use();
+        objectIndexLocation = m_resources.objectIndexLocationGBuffer;
+        break;
+    case SHADING_CLUSTERED:
+        // Falls back to Phong without shader storage buffers
+        if (!ClusteredLights::isSupported())
+        {
+            m_currentShading = 2;
+            m_resources.phong.use();
+            viewMatrixLocation = m_resources.viewLocationPhong;
+            objectIndexLocation = m_resources.objectIndexLocationPhong;
+            break;
+        }
+        {
+            ProfileScope scope(m_resources.profiler, "Light clusters");
+            // The extra lights don't move, they are only placed when their count changes
+            if (m_clusteredLights.getLightCount() != size_t(3 + m_extraLightCount))
+            {
+                m_clusteredLights.setLightCount(3 + m_extraLightCount);
+                setExtraLights(m_clusteredLights, 3, m_extraLightCount);
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                m_clusteredLights.setLight(i, glm::vec3(m_lights[i].position), 0.0f, glm::vec3(m_lights[i].spotDirection),
+                                           glm::vec3(m_lights[i].diffuse), glm::vec3(m_lights[i].specular));
+            }
+            m_clusteredLights.update(view, projPersp);
+        }
+        m_clusteredLights.bind(LIGHT_BUFFER_BINDING, CLUSTER_BUFFER_BINDING, LIGHT_INDEX_BUFFER_BINDING);
+        m_resources.clustered.use();
+        viewMatrixLocation = m_resources.viewLocationClustered;
+        glUniform2f(m_resources.viewportSizeLocationClustered, w.getWidth(), w.getHeight());
+        glUniform1f(m_resources.depthSliceScaleLocationClustered, m_clusteredLights.getDepthSliceScale());
+        glUniform1f(m_resources.depthSliceBiasLocationClustered, m_clusteredLights.getDepthSliceBias());
+        objectIndexLocation = m_resources.objectIndexLocationClustered;
         break;
     }
+    const bool isDeferred = m_currentShading == SHADING_DEFERRED;
     m_diffuseMapTexture.use(0);
     m_specularMapTexture.use(1);
 
     glUniformMatrix4fv(viewMatrixLocation, 1, GL_FALSE, &view[0][0]);
-    glm::mat4 sphereModel = glm::mat4(1.0f);
-    mvp = projView * sphereModel;
-    modelView = view * sphereModel;
-    glUniformMatrix4fv(mvpMatrixLocation, 1, GL_FALSE, &mvp[0][0]);
-    glUniformMatrix4fv(modelViewMatrixLocation, 1, GL_FALSE, &modelView[0][0]);
-    glUniformMatrix3fv(normalMatrixLocation, 1, GL_TRUE, glm::value_ptr(glm::inverse(glm::mat3(modelView))));
-
-    switch (m_currentModel)
     {
-    case 0: m_sphere.draw(); break;
-    case 1: m_cube.draw(); break;
-    case 2: m_suzanne.draw(); break;
+        ProfileScope scope(m_resources.profiler, "Object");
+        glUniform1i(objectIndexLocation, OBJECT_INDEX);
+        if (m_culler.isVisible(OBJECT_INDEX))
+            model.draw();
     }
 
-    m_whiteTexture.use(0);
-    m_whiteTexture.use(1);
-    for (size_t i = 0; i < 3; ++i)
     {
-        glm::mat4 lightModel = glm::mat4(1.0f);
-        lightModel = glm::translate(lightModel, glm::vec3(m_lights[i].position));
-        lightModel = glm::rotate(lightModel, glm::radians(orientation[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
-        lightModel = glm::rotate(lightModel, glm::radians(orientation[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
-        m_lights[i].spotDirection = lightModel * glm::vec4(0, -1, 0, 0);
-
-        mvp = projView * lightModel;
-        modelView = view * lightModel;
-        glUniformMatrix4fv(mvpMatrixLocation, 1, GL_FALSE, &mvp[0][0]);
-        glUniformMatrix4fv(modelViewMatrixLocation, 1, GL_FALSE, &modelView[0][0]);
-        glUniformMatrix3fv(normalMatrixLocation, 1, GL_TRUE, glm::value_ptr(glm::inverse(glm::mat3(modelView))));
-
-        Material lightMaterial =
+        ProfileScope scope(m_resources.profiler, "Lights");
+        m_whiteTexture.use(0);
+        m_whiteTexture.use(1);
+        for (int i = 0; i < 3; ++i)
         {
-            m_lights[i].diffuse,
-            glm::vec4(0.0f),
-            glm::vec4(0.0f),
-            glm::vec3(0.0f),
-            1.0f
-        };
-        m_lightingData.updateData(&lightMaterial, 0, sizeof(lightMaterial));
-        m_spotlight.draw();
+            if (!m_culler.isVisible(FIRST_LIGHT_INDEX + i))
+                continue;
+            glUniform1i(objectIndexLocation, FIRST_LIGHT_INDEX + i);
+
+            block.material =
+            {
+                m_lights[i].diffuse,
+                glm::vec4(0.0f),
+                glm::vec4(0.0f),
+                glm::vec3(0.0f),
+                1.0f
+            };
+            m_lightingData.bindData(LIGHTING_BLOCK_BINDING, &block, sizeof(block));
+            m_spotlight.draw();
+        }
     }
+
+    if (isDeferred)
+    {
+        // Each pixel is lit once, by every light, from the G-buffer
+        ProfileScope scope(m_resources.profiler, "Deferred lighting");
+        m_gbuffer.end();
+        m_resources.deferred.use();
+        glm::mat4 invProjection = glm::inverse(projPersp);
+        glUniformMatrix4fv(m_resources.viewLocationDeferred, 1, GL_FALSE, &view[0][0]);
+        glUniformMatrix4fv(m_resources.invProjectionLocationDeferred, 1, GL_FALSE, &invProjection[0][0]);
+        m_gbuffer.bindTextures(0);
+
+        GLState::setEnabled(GL_DEPTH_TEST, false);
+        m_gbuffer.drawScreenTriangle();
+        GLState::setEnabled(GL_DEPTH_TEST, true);
+    }
+}
+
+void SceneLighting::setCamera(const glm::vec2& orientation)
+{
+    m_cameraOrientation = orientation;
+}
+
+void SceneLighting::setShading(int shading)
+{
+    m_currentShading = shading;
 }
 
 void SceneLighting::updateInput(Window& w, double dt)
@@ -212,11 +383,13 @@ void SceneLighting::drawMenu()
 {
     if (!m_menuVisible) return;
     const char* modelList[] = { "Sphere", "Cube", "Monkey" };
-    const char* shadingList[] = { "Flat", "Gouraud", "Phong" };
+    const char* shadingList[] = { "Flat", "Gouraud", "Phong", "Deferred", "Clustered" };
 
     ImGui::Begin("Scene Parameters");
 
     ImGui::Combo("Model", &m_currentModel, modelList, sizeof(modelList) / sizeof(modelList[0]));
+    const FrustumCuller::Stats& culling = m_culler.getStats();
+    ImGui::Text("Frustum culling: %d visible, %d culled", culling.visible, culling.culled);
     ImGui::SeparatorText("Material");
     ImGui::ColorEdit3("Emission##m", &m_material.emission[0]);
     ImGui::ColorEdit3("Ambient##m", &m_material.ambient[0]);
@@ -232,6 +405,13 @@ void SceneLighting::drawMenu()
     ImGui::Checkbox("Use Direct3D?", (bool*)&m_lightModel.useDirect3D);
     ImGui::DragFloat("Spot Exponent", &m_lightModel.spotExponent, 0.5f, 0.0f, 500.0f);
     ImGui::DragFloat("Spot Opening", &m_lightModel.spotOpeningAngle, 0.5f, 0.0f, 360.0f);
+    if (m_currentShading == SHADING_CLUSTERED)
+    {
+        ImGui::SliderInt("Extra spotlights", &m_extraLightCount, 0, MAX_EXTRA_LIGHTS);
+        const ClusteredLights::Stats& clusters = m_clusteredLights.getStats();
+        ImGui::Text("Clusters: %d lights, %d assignments, max %d per cluster",
+                    clusters.lights, clusters.assignments, clusters.maxPerCluster);
+    }
     
     if (ImGui::Button("Preset color"))
     {
@@ -5,9 +5,14 @@
 
 #include <glm/glm.hpp>
 
+#include "clustered_lights.h"
+#include "frustum_culler.h"
+#include "gbuffer.h"
+#include "geometry_pool.h"
 #include "model.h"
 #include "texture.h"
-#include "uniform_buffer.h"
+#include "transform_batch.h"
+#include "uniform_ring.h"
 
 
 
@@ -39,6 +44,17 @@ struct LightModel
     GLfloat spotOpeningAngle;
 };
 
+// Size of ObjectBlock::objects in the lighting shaders
+const int MAX_OBJECTS = 4;
+
+// std140 layout of LightingBlock
+struct LightingBlock
+{
+    Material material;
+    UniversalLight lights[3];
+    LightModel lightModel;
+};
+
 
 class SceneLighting : public Scene
 {
@@ -46,6 +62,14 @@ public:
     SceneLighting(Resources& res, bool& isMouseMotionEnabled);
 
     virtual void run(Window& w, double dt);
+
+    // Starts loading the meshes and textures of the scene in the background
+    static void requestAssets(AssetLoader& loader);
+
+    // Orientation in radians (pitch, yaw), for scripted cameras
+    void setCamera(const glm::vec2& orientation);
+    // 0 flat, 1 gouraud, 2 phong, 3 deferred, 4 clustered
+    void setShading(int shading);
     
 private:
     void updateInput(Window& w, double dt);
@@ -60,6 +84,7 @@ private:
 
     glm::vec2 m_cameraOrientation;
 
+    GeometryPool m_geometry;
     Model m_suzanne;
     Model m_sphere;
     Model m_cube;
@@ -72,7 +97,9 @@ private:
     LightModel m_lightModel;
     Material m_material;
     UniversalLight m_lights[3];
-    UniformBuffer m_lightingData;
+    UniformRing m_lightingData;
+    TransformBatch m_transforms;
+    FrustumCuller m_culler;
 
     glm::vec2 orientation[3];
 
@@ -80,6 +107,13 @@ private:
     int m_currentModel;
     int m_currentShading;
     bool m_menuVisible;
+
+    GBuffer m_gbuffer;
+
+    // Clustered shading: the three lights, then m_extraLightCount spotlights
+    // of limited range around the object
+    ClusteredLights m_clusteredLights;
+    int m_extraLightCount;
 };
 
 #endif // SCENE_LIGHTING_H
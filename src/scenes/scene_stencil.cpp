@@ -10,6 +10,67 @@
 
 #include <iostream>
 
+namespace
+{
+    // Order required by the stencil and the transparency
+    enum Layer
+    {
+        LAYER_SUZANNE,
+        LAYER_ROCK,
+        LAYER_XRAY,
+        LAYER_STATUES,
+        LAYER_GLASS,
+    };
+
+    const char* const LAYER_NAMES[] = { "Suzanne", "Rock", "X-ray Suzanne", "Statues", "Glass" };
+
+    // Indices in m_bindlessTextures or layers of m_propTextureArray
+    enum PropTexture
+    {
+        PROP_SUZANNE,
+        PROP_SUZANNE_WHITE,
+        PROP_ROCK,
+        PROP_GLASS,
+        N_PROP_TEXTURES,
+    };
+    const GLsizei PROP_TEXTURE_SIZE = 1024;
+
+    const unsigned int MESH_FLAGS = Model::OPTIMIZE_VERTEX_CACHE | Model::QUANTIZE_VERTICES | Model::GENERATE_LODS
+                                    | Model::BUILD_MESHLETS;
+    const char* const SUZANNE_PATH = "../models/suzanne.obj";
+    const char* const ROCK_PATH = "../models/rock.obj";
+    const char* const GLASS_PATH = "../models/glass.obj";
+
+    const char* const GROUND_TEXTURE_PATH = "../textures/grassSeamless.jpg";
+    const char* const SUZANNE_TEXTURE_PATH = "../textures/suzanneTextureShade.png";
+    const char* const SUZANNE_WHITE_TEXTURE_PATH = "../textures/suzanneWhite.png";
+    const char* const ROCK_TEXTURE_PATH = "../textures/rockTexture.png";
+    const char* const GLASS_TEXTURE_PATH = "../textures/glass.png";
+    const char* const WHITE_GRID_TEXTURE_PATH = "../textures/whiteGrid.png";
+
+    const char* const PROP_TEXTURE_PATHS[N_PROP_TEXTURES] = {
+        SUZANNE_TEXTURE_PATH,
+        SUZANNE_WHITE_TEXTURE_PATH,
+        ROCK_TEXTURE_PATH,
+        GLASS_TEXTURE_PATH,
+    };
+
+    const GLuint BINDLESS_TEXTURES_BINDING = 1; // see textureBindless.fs.glsl
+}
+
+void SceneStencil::requestAssets(AssetLoader& loader)
+{
+    loader.requestMesh(SUZANNE_PATH, MESH_FLAGS);
+    loader.requestMesh(ROCK_PATH, MESH_FLAGS);
+    loader.requestMesh(GLASS_PATH, Model::QUANTIZE_VERTICES);
+
+    loader.requestImage(GROUND_TEXTURE_PATH);
+    loader.requestImage(WHITE_GRID_TEXTURE_PATH);
+    // The layers of a texture array are uncompressed
+    for (const char* path : PROP_TEXTURE_PATHS)
+        loader.requestImage(path, BindlessTextureTable::isSupported());
+}
+
 SceneStencil::SceneStencil(Resources& res, bool& isMouseMotionEnabled)
 : Scene(res)
 , m_isMouseMotionEnabled(isMouseMotionEnabled)
@@ -21,16 +82,18 @@ SceneStencil::SceneStencil(Resources& res, bool& isMouseMotionEnabled)
 , m_groundVao()
 , m_groundDraw(m_groundVao, 6)
 
-, m_suzanne("../models/suzanne.obj")
-, m_rock("../models/rock.obj")
-, m_glass("../models/glass.obj")
+, m_geometry(true)
+, m_suzanne(m_geometry, res.assets.getMesh(SUZANNE_PATH, MESH_FLAGS))
+, m_rock(m_geometry, res.assets.getMesh(ROCK_PATH, MESH_FLAGS))
+, m_glass(m_geometry, res.assets.getMesh(GLASS_PATH, Model::QUANTIZE_VERTICES))
 
-, m_groundTexture("../textures/grassSeamless.jpg")
-, m_suzanneTexture("../textures/suzanneTextureShade.png")
-, m_suzanneWhiteTexture("../textures/suzanneWhite.png")
-, m_rockTexture("../textures/rockTexture.png")
-, m_glassTexture("../textures/glass.png")
-, m_whiteGridTexture("../textures/whiteGrid.png")
+, m_groundTexture()
+, m_whiteGridTexture(res.assets.getImage(WHITE_GRID_TEXTURE_PATH))
+
+, m_occlusionCuller(res.simpleColor, res.mvpLocationSimpleColor)
+, m_isOcclusionCullingEnabled(true)
+, m_lodPixelError(1.0f)
+, m_isMeshletCullingEnabled(true)
 {
     m_groundVao.specifyAttribute(m_groundBuffer, 0, 3, 5, 0);
     m_groundVao.specifyAttribute(m_groundBuffer, 1, 2, 5, 3);
@@ -42,21 +105,33 @@ SceneStencil::SceneStencil(Resources& res, bool& isMouseMotionEnabled)
     m_groundTexture.setFiltering(GL_LINEAR);
     m_groundTexture.setWrap(GL_REPEAT);
     m_groundTexture.enableMipmap();
+    res.textureStreamer.stream(m_groundTexture, GROUND_TEXTURE_PATH);
     
-    m_suzanneTexture.setFiltering(GL_LINEAR);
-    m_suzanneTexture.setWrap(GL_CLAMP_TO_EDGE);
-    
-    m_suzanneWhiteTexture.setFiltering(GL_LINEAR);
-    m_suzanneWhiteTexture.setWrap(GL_CLAMP_TO_EDGE);
-
-    m_rockTexture.setFiltering(GL_LINEAR);
-    m_rockTexture.setWrap(GL_CLAMP_TO_EDGE);
-    
-    m_glassTexture.setFiltering(GL_LINEAR);
-    m_glassTexture.setWrap(GL_CLAMP_TO_EDGE);
+    if (BindlessTextureTable::isSupported())
+    {
+        for (int i = 0; i < N_PROP_TEXTURES; i++)
+        {
+            Texture2D* texture = new Texture2D(res.assets.getImage(PROP_TEXTURE_PATHS[i]));
+            texture->setFiltering(GL_LINEAR);
+            texture->setWrap(GL_CLAMP_TO_EDGE);
+            m_propTextures.emplace_back(texture);
+            m_bindlessTextures.add(*texture); // index i, the handles are distinct
+        }
+    }
+    else
+    {
+        m_propTextureArray.reset(new TextureArray(PROP_TEXTURE_SIZE, PROP_TEXTURE_SIZE, N_PROP_TEXTURES));
+        for (int i = 0; i < N_PROP_TEXTURES; i++)
+            m_propTextureArray->setLayer(i, res.assets.getImage(PROP_TEXTURE_PATHS[i], false));
+        m_propTextureArray->setFiltering(GL_LINEAR);
+        m_propTextureArray->setWrap(GL_CLAMP_TO_EDGE);
+    }
     
     m_whiteGridTexture.setFiltering(GL_LINEAR);
     m_whiteGridTexture.setWrap(GL_REPEAT);
+
+    m_geometry.upload();
+    m_renderQueue.setProfiler(&m_resources.profiler, LAYER_NAMES);
 }
 
 SceneStencil::~SceneStencil(){}
@@ -65,15 +140,78 @@ void SceneStencil::run(Window& w, double dt)
 {
     updateInput(w, dt);
 
+    const RenderQueue::Stats& stats = m_renderQueue.getStats();
+    ImGui::Begin("Scene Parameters");
+    ImGui::Text("Render queue: %d items, %d culled, %d draws", stats.items, stats.culled, stats.drawCalls);
+    ImGui::Text("State changes: %d program, %d texture, %d fixed function, %d avoided",
+                stats.programChanges, stats.textureChanges, stats.stateChanges, stats.changesAvoided);
+    ImGui::Checkbox("Occlusion culling", &m_isOcclusionCullingEnabled);
+    if (m_isOcclusionCullingEnabled)
+    {
+        const OcclusionCuller::Stats& occlusion = m_occlusionCuller.getStats();
+        ImGui::SameLine();
+        ImGui::Text("%d tested, %d hidden", occlusion.tested, occlusion.hidden);
+    }
+    ImGui::SliderFloat("LOD error (pixels)", &m_lodPixelError, 0.0f, 8.0f);
+    ImGui::Checkbox("Meshlet culling", &m_isMeshletCullingEnabled);
+    if (m_isMeshletCullingEnabled)
+    {
+        const MeshletCuller::Stats& meshlets = m_renderQueue.getMeshletStats();
+        ImGui::SameLine();
+        ImGui::Text("%d/%d culled, %d/%d triangles", meshlets.culled, meshlets.meshlets,
+                    meshlets.trianglesCulled, meshlets.triangles);
+    }
+    ImGui::End();
+    m_renderQueue.beginFrame();
+    m_renderQueue.setMeshletCullingEnabled(m_isMeshletCullingEnabled);
+
     glm::mat4 proj, view, mvp;
     
     proj = getProjectionMatrix(w);    
     view = getCameraFirstPerson();    
     glm::mat4 projView = proj * view;
+
+    glm::mat4 modelGround = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f));
+    glm::mat4 modelSuzanne = glm::translate(glm::mat4(1.0f), glm::vec3(-14.0f, -0.1f, 2.0f));
+    glm::mat4 modelRock = glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, 0.4f, 0.0f));
+    modelRock = glm::scale(modelRock, glm::vec3(2.0f, 2.0f, 2.0f));
+    glm::mat4 modelGlass = glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, -0.1f, 0.0f));
+    modelGlass = glm::scale(modelGlass, glm::vec3(2.0f, 2.0f, 2.0f));
+
+    const glm::vec3 monkeyPositions[] = {
+        {12.0f, -0.1f,  4.0f},
+        {12.0f, -0.1f,  0.0f},
+        {12.0f, -0.1f, -4.0f}
+    };
+    glm::mat4 modelStatues[3];
+    for (int i = 0; i < 3; i++)
+    {
+        modelStatues[i] = glm::translate(glm::mat4(1.0f), monkeyPositions[i]);
+        modelStatues[i] = glm::rotate(modelStatues[i], glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    // Props far from the camera use a simplified mesh
+    const GLfloat pixelsPerUnit = Model::getLodPixelsPerUnit(proj, w.getHeight());
+    const int suzanneLod = m_suzanne.selectLod(modelSuzanne, m_cameraPosition, pixelsPerUnit, m_lodPixelError);
+
+    // The ground and the rock hide the other props: the props' boxes are
+    // tested against their depth, and hidden props are not drawn
+    GLuint suzanneQuery = 0, statuesQuery = 0, glassQuery = 0;
+    if (m_isOcclusionCullingEnabled)
+    {
+        ProfileScope scope(m_resources.profiler, "Occlusion");
+        m_occlusionCuller.begin(projView, m_cameraPosition);
+        m_occlusionCuller.drawOccluder(m_groundDraw, modelGround);
+        m_occlusionCuller.drawOccluder(m_rock, modelRock);
+        suzanneQuery = m_occlusionCuller.test(m_suzanne, &modelSuzanne);
+        statuesQuery = m_occlusionCuller.test(m_suzanne, modelStatues, 3);
+        glassQuery = m_occlusionCuller.test(m_glass, &modelGlass);
+        m_occlusionCuller.end();
+    }
     
     // sol
     {
-        glm::mat4 modelGround = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f));
+        ProfileScope scope(m_resources.profiler, "Ground");
         mvp = projView * modelGround;
         m_resources.texture.use();
         m_groundTexture.use();
@@ -81,96 +219,102 @@ void SceneStencil::run(Window& w, double dt)
         m_groundDraw.draw();
     }
 
-    // real Suzanne
-    glm::mat4 modelSuzanne = glm::translate(glm::mat4(1.0f), glm::vec3(-14.0f, -0.1f, 2.0f));
+    // Each prop instance picks its own texture, without rebinding
+    ShaderProgram* propProgram = &m_resources.textureArrayInstanced;
+    GLint propProjViewLocation = m_resources.projViewLocationTextureArrayInstanced;
+    if (!m_propTextureArray)
     {
-        glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-        glStencilMask(0x00);
+        propProgram = &m_resources.textureBindlessInstanced;
+        propProjViewLocation = m_resources.projViewLocationTextureBindlessInstanced;
+        m_bindlessTextures.bind(BINDLESS_TEXTURES_BINDING);
+    }
 
-        mvp = projView * modelSuzanne;
-        m_resources.texture.use();
-        m_suzanneTexture.use();
-        glUniformMatrix4fv(m_resources.mvpLocationTexture, 1, GL_FALSE, &mvp[0][0]);
-        m_suzanne.draw();
+    // real Suzanne
+    RenderItem item = {};
+    item.program = propProgram;
+    item.projViewLocation = propProjViewLocation;
+    item.textureArray = m_propTextureArray.get();
+
+    {
+        item.layer = LAYER_SUZANNE;
+        item.state = { GL_NOTEQUAL, 1, 0x00, GL_KEEP, true, false, true };
+        item.textureLayer = PROP_SUZANNE;
+        item.model = &m_suzanne;
+        item.lod = suzanneLod;
+        item.transform = modelSuzanne;
+        item.occlusionQuery = suzanneQuery;
+        m_renderQueue.submit(item);
     }
 
     // roche
-    glStencilFunc(GL_ALWAYS, 1, 0xFF);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    glStencilMask(0xFF);
-
-    glm::mat4 modelRock = glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, 0.4f, 0.0f));
-    modelRock = glm::scale(modelRock, glm::vec3(2.0f, 2.0f, 2.0f));
+    item.occlusionQuery = 0;
     {
-        mvp = projView * modelRock;
-        m_resources.texture.use();
-        m_rockTexture.use();
-        glUniformMatrix4fv(m_resources.mvpLocationTexture, 1, GL_FALSE, &mvp[0][0]);
-        m_rock.draw();
+        item.layer = LAYER_ROCK;
+        item.state = { GL_ALWAYS, 1, 0xFF, GL_REPLACE, true, false, true };
+        item.textureLayer = PROP_ROCK;
+        item.model = &m_rock;
+        item.lod = m_rock.selectLod(modelRock, m_cameraPosition, pixelsPerUnit, m_lodPixelError);
+        item.transform = modelRock;
+        m_renderQueue.submit(item);
     }
-    glStencilMask(0x00);
 
     // simple color Suzanne
-    glDisable(GL_DEPTH_TEST); // Désactiver, sinon on va toujours voir la roche par dessus
     {
-        glStencilFunc(GL_EQUAL, 1, 0xFF);
-        glStencilMask(0x00);
-
-        mvp = projView * modelSuzanne;
-        m_resources.simpleColor.use();
-        m_whiteGridTexture.use();
-        glUniformMatrix4fv(m_resources.mvpLocationSimpleColor, 1, GL_FALSE, &mvp[0][0]);
-        m_suzanne.draw();
+        // Sans test de profondeur, sinon on va toujours voir la roche par dessus.
+        // Never occlusion culled, the effect needs it behind the rock
+        item.layer = LAYER_XRAY;
+        item.state = { GL_EQUAL, 1, 0x00, GL_KEEP, false, false, true };
+        item.program = &m_resources.simpleColorInstanced;
+        item.projViewLocation = m_resources.projViewLocationSimpleColorInstanced;
+        item.textureArray = nullptr;
+        item.textures[0] = &m_whiteGridTexture;
+        item.model = &m_suzanne;
+        item.lod = suzanneLod;
+        item.transform = modelSuzanne;
+        m_renderQueue.submit(item);
     }
 
-    glEnable(GL_DEPTH_TEST);
-    glStencilFunc(GL_ALWAYS, 0, 0xFF);
-    glStencilMask(0xFF);
+    m_renderQueue.flush(projView, m_cameraPosition);
     glClear(GL_STENCIL_BUFFER_BIT);
 
     // monkeys statues
+    item.program = propProgram;
+    item.projViewLocation = propProjViewLocation;
+    item.textureArray = m_propTextureArray.get();
+    item.textures[0] = nullptr;
     {
-        const std::vector<glm::vec3> monkeyPositions = {
-            {12.0f, -0.1f,  4.0f},
-            {12.0f, -0.1f,  0.0f},
-            {12.0f, -0.1f, -4.0f}
-        };
-        m_resources.texture.use();
-        m_suzanneWhiteTexture.use();
-        glm::mat4 modelStatue;
+        item.layer = LAYER_STATUES;
+        item.state = { GL_NOTEQUAL, 1, 0x00, GL_KEEP, true, false, true };
+        item.textureLayer = PROP_SUZANNE_WHITE;
+        item.model = &m_suzanne;
+        item.occlusionQuery = statuesQuery;
 
-        for (const auto& pos : monkeyPositions) {
-            modelStatue = glm::translate(glm::mat4(1.0f), pos);
-            modelStatue = glm::rotate(modelStatue, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        
-            glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-            glStencilMask(0x00);
-        
-            mvp = projView * modelStatue;
-            glUniformMatrix4fv(m_resources.mvpLocationTexture, 1, GL_FALSE, &mvp[0][0]);
-        
-            m_suzanne.draw();
+        for (const glm::mat4& modelStatue : modelStatues) {
+            item.lod = m_suzanne.selectLod(modelStatue, m_cameraPosition, pixelsPerUnit, m_lodPixelError);
+            item.transform = modelStatue;
+            m_renderQueue.submit(item);
         }
     }
     
     // vitre
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_CULL_FACE);
-
     {
-        glm::mat4 modelGlass = glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, -0.1f, 0.0f));
-        modelGlass = glm::scale(modelGlass, glm::vec3(2.0f, 2.0f, 2.0f));
-
-        mvp = projView * modelGlass;
-        m_resources.texture.use();
-        m_glassTexture.use();
-        glUniformMatrix4fv(m_resources.mvpLocationTexture, 1, GL_FALSE, &mvp[0][0]);
-        m_glass.draw();
+        item.layer = LAYER_GLASS;
+        item.state = { GL_NOTEQUAL, 1, 0x00, GL_KEEP, true, true, false };
+        item.textureLayer = PROP_GLASS;
+        item.model = &m_glass;
+        item.lod = 0;
+        item.transform = modelGlass;
+        item.occlusionQuery = glassQuery;
+        m_renderQueue.submit(item);
     }
-    
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
+
+    m_renderQueue.flush(projView, m_cameraPosition);
+}
+
+void SceneStencil::setCamera(const glm::vec3& position, const glm::vec2& orientation)
+{
+    m_cameraPosition = position;
+    m_cameraOrientation = orientation;
 }
 
 void SceneStencil::updateInput(Window& w, double dt)
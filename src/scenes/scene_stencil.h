@@ -5,8 +5,16 @@
 
 #include <glm/glm.hpp>
 
+#include <memory>
+#include <vector>
+
+#include "bindless_texture_table.h"
+#include "geometry_pool.h"
 #include "model.h"
+#include "occlusion_culler.h"
+#include "render_queue.h"
 #include "texture.h"
+#include "texture_array.h"
 
 
 class SceneStencil : public Scene
@@ -17,6 +25,12 @@ public:
 
     virtual void run(Window& w, double dt);
 
+    // Starts loading the meshes and textures of the scene in the background
+    static void requestAssets(AssetLoader& loader);
+
+    // Orientation in radians (pitch, yaw), for scripted cameras
+    void setCamera(const glm::vec3& position, const glm::vec2& orientation);
+
 private:
     void updateInput(Window& w, double dt);
     
@@ -36,16 +50,26 @@ private:
     VertexArrayObject m_groundVao;
     DrawElementsCommand m_groundDraw;
     
+    GeometryPool m_geometry;
     Model m_suzanne;
     Model m_rock;
     Model m_glass;
+
+    RenderQueue m_renderQueue;
     
     Texture2D m_groundTexture;
-    Texture2D m_suzanneTexture;
-    Texture2D m_suzanneWhiteTexture;
-    Texture2D m_rockTexture;
-    Texture2D m_glassTexture;
+    // Textures of the props: bindless handles when supported, otherwise the
+    // layers of a texture array
+    std::vector<std::unique_ptr<Texture2D>> m_propTextures;
+    BindlessTextureTable m_bindlessTextures;
+    std::unique_ptr<TextureArray> m_propTextureArray;
     Texture2D m_whiteGridTexture;
+
+    OcclusionCuller m_occlusionCuller;
+    bool m_isOcclusionCullingEnabled;
+    // Screen-space error allowed when choosing the level of detail of the props
+    float m_lodPixelError;
+    bool m_isMeshletCullingEnabled;
 };
 
 
@@ -0,0 +1,60 @@
+#include "shader_program.h"
+
+#include <iostream>
+
+#include "gl_state.h"
+#include "shader_object.h"
+
+ShaderProgram::ShaderProgram(const char* name)
+: m_name(name)
+{
+    m_id = glCreateProgram();
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    GLState::deleteProgram(m_id);
+}
+
+void ShaderProgram::use()
+{
+    GLState::useProgram(m_id);
+}
+
+void ShaderProgram::attachShaderObject(ShaderObject& s)
+{
+    glAttachShader(m_id, s.id());
+}
+
+void ShaderProgram::link()
+{
+    glLinkProgram(m_id);
+    checkLinkingError();
+}
+
+GLint ShaderProgram::getUniformLoc(const char* name)
+{
+    return glGetUniformLocation(m_id, name);
+}
+
+void ShaderProgram::setUniformBlockBinding(const char* name, GLuint bindingIndex)
+{
+    GLuint index = glGetUniformBlockIndex(m_id, name);
+    if (index == GL_INVALID_INDEX)
+        return; // unused by the shaders, optimized out
+    glUniformBlockBinding(m_id, index, bindingIndex);
+}
+
+void ShaderProgram::checkLinkingError()
+{
+    GLint success;
+    GLchar infoLog[1024];
+
+    glGetProgramiv(m_id, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(m_id, 1024, NULL, infoLog);
+        GLState::deleteProgram(m_id);
+        std::cout << "Program \"" << m_name << "\" linking error: " << infoLog << std::endl;
+    }
+}
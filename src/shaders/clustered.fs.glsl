@@ -0,0 +1,139 @@
+#version 430 core
+
+in ATTRIB_VS_OUT
+{
+    vec2 texCoords;
+    vec3 normal;
+    vec3 position; // view space
+} attribIn;
+
+struct Material
+{
+    vec3 emission;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+
+struct UniversalLight
+{
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    vec3 position;
+    vec3 spotDirection;
+};
+
+// The material and the light model, the lights only give the ambient terms
+layout (std140) uniform LightingBlock
+{
+    Material mat;
+    UniversalLight lights[3];
+    vec3 lightModelAmbient;
+    bool useBlinn;
+    bool useSpotlight;
+    bool useDirect3D;
+    float spotExponent;
+    float spotOpeningAngle;
+};
+
+// See ClusteredLights, in world space
+struct ClusterLight
+{
+    vec4 positionRange; // w: range, 0 for a light reaching everything
+    vec4 diffuse;
+    vec4 specular;
+    vec4 direction;
+};
+
+layout(std430, binding = 0) readonly buffer LightBuffer
+{
+    ClusterLight clusterLights[];
+};
+
+// Offset and count in lightIndices, per froxel
+layout(std430, binding = 1) readonly buffer ClusterBuffer
+{
+    uvec2 clusters[];
+};
+
+layout(std430, binding = 2) readonly buffer LightIndexBuffer
+{
+    uint lightIndices[];
+};
+
+// ClusteredLights::GRID_X, GRID_Y and GRID_Z
+uniform ivec3 clusterGrid;
+uniform vec2 viewportSize;
+uniform mat4 view;
+// Slice of a view depth d: int(log(d) * scale + bias)
+uniform float depthSliceScale;
+uniform float depthSliceBias;
+
+uniform sampler2D diffuseSampler;
+uniform sampler2D specularSampler;
+
+out vec4 FragColor;
+
+// lightDir: from the surface to the light, spotDir: from the light
+float spotFactor(vec3 lightDir, vec3 spotDir)
+{
+    float cosGamma = dot(-lightDir, spotDir);
+    float cosDelta = cos(radians(spotOpeningAngle));
+    if (useDirect3D)
+    {
+        float cosInner = pow(cosDelta, 1.01 + spotExponent / 2.0);
+        return smoothstep(cosDelta, cosInner, cosGamma);
+    }
+    return cosGamma > cosDelta ? pow(cosGamma, spotExponent) : 0.0;
+}
+
+void main()
+{
+    vec3 diffuseTexel = texture(diffuseSampler, attribIn.texCoords).rgb;
+    float specularTexel = texture(specularSampler, attribIn.texCoords).r;
+    vec3 N = normalize(attribIn.normal);
+    vec3 O = normalize(-attribIn.position);
+
+    vec3 ambient = lightModelAmbient;
+    for (int i = 0; i < 3; i++)
+        ambient += lights[i].ambient;
+    vec3 color = mat.emission + mat.ambient * diffuseTexel * ambient;
+
+    ivec3 cell = ivec3(vec3(gl_FragCoord.xy / viewportSize, 0.0) * vec3(clusterGrid));
+    cell.z = int(log(-attribIn.position.z) * depthSliceScale + depthSliceBias);
+    cell = clamp(cell, ivec3(0), clusterGrid - 1);
+    uvec2 cluster = clusters[(cell.z * clusterGrid.y + cell.y) * clusterGrid.x + cell.x];
+
+    for (uint i = 0u; i < cluster.y; i++)
+    {
+        ClusterLight light = clusterLights[lightIndices[cluster.x + i]];
+        vec3 toLight = vec3(view * vec4(light.positionRange.xyz, 1.0)) - attribIn.position;
+        float distance = length(toLight);
+        vec3 L = toLight / distance;
+
+        // Smooth window reaching 0 at the range
+        float attenuation = 1.0;
+        if (light.positionRange.w > 0.0)
+        {
+            float ratio = distance / light.positionRange.w;
+            attenuation = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+            attenuation *= attenuation;
+        }
+        if (useSpotlight)
+            attenuation *= spotFactor(L, mat3(view) * light.direction.xyz);
+
+        float NdotL = max(dot(N, L), 0.0);
+        float reflection = 0.0;
+        if (NdotL > 0.0)
+        {
+            reflection = useBlinn ? max(dot(normalize(L + O), N), 0.0)
+                                  : max(dot(reflect(-L, N), O), 0.0);
+            reflection = pow(reflection, mat.shininess);
+        }
+        color += attenuation * (light.diffuse.rgb * mat.diffuse * diffuseTexel * NdotL
+                                + light.specular.rgb * mat.specular * specularTexel * reflection);
+    }
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,101 @@
+#version 330 core
+
+struct Material
+{
+    vec3 emission;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+
+struct UniversalLight
+{
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    vec3 position;
+    vec3 spotDirection;
+};
+
+// Only the lights and the light model are read, the material is in the G-buffer
+layout (std140) uniform LightingBlock
+{
+    Material mat;
+    UniversalLight lights[3];
+    vec3 lightModelAmbient;
+    bool useBlinn;
+    bool useSpotlight;
+    bool useDirect3D;
+    float spotExponent;
+    float spotOpeningAngle;
+};
+
+// See GBuffer::Target
+uniform sampler2D albedoSampler;
+uniform sampler2D specularSampler;
+uniform sampler2D normalSampler;
+uniform sampler2D emissionSampler;
+uniform sampler2D depthSampler;
+
+uniform mat4 view;
+uniform mat4 invProjection;
+
+out vec4 FragColor;
+
+vec3 viewPosition(ivec2 pixel, float depth)
+{
+    vec2 ndc = (vec2(pixel) + 0.5) / vec2(textureSize(depthSampler, 0)) * 2.0 - 1.0;
+    vec4 position = invProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+// lightDir: from the surface to the light, spotDir: from the light
+float spotFactor(vec3 lightDir, vec3 spotDir)
+{
+    float cosGamma = dot(-lightDir, spotDir);
+    float cosDelta = cos(radians(spotOpeningAngle));
+    if (useDirect3D)
+    {
+        float cosInner = pow(cosDelta, 1.01 + spotExponent / 2.0);
+        return smoothstep(cosDelta, cosInner, cosGamma);
+    }
+    return cosGamma > cosDelta ? pow(cosGamma, spotExponent) : 0.0;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(depthSampler, pixel, 0).r;
+    // Nothing was drawn, the clear color stays
+    if (depth == 1.0)
+        discard;
+
+    vec3 albedo = texelFetch(albedoSampler, pixel, 0).rgb;
+    vec4 specular = texelFetch(specularSampler, pixel, 0);
+    vec3 N = normalize(texelFetch(normalSampler, pixel, 0).xyz);
+    vec3 position = viewPosition(pixel, depth);
+    vec3 O = normalize(-position);
+
+    vec3 color = texelFetch(emissionSampler, pixel, 0).rgb;
+    for (int i = 0; i < 3; i++)
+    {
+        vec3 lightPosition = vec3(view * vec4(lights[i].position, 1.0));
+        vec3 L = normalize(lightPosition - position);
+
+        float spot = 1.0;
+        if (useSpotlight)
+            spot = spotFactor(L, normalize(mat3(view) * lights[i].spotDirection));
+
+        float NdotL = max(dot(N, L), 0.0);
+        float reflection = 0.0;
+        if (NdotL > 0.0)
+        {
+            reflection = useBlinn ? max(dot(normalize(L + O), N), 0.0)
+                                  : max(dot(reflect(-L, N), O), 0.0);
+            reflection = pow(reflection, specular.a);
+        }
+        color += spot * (lights[i].diffuse * albedo * NdotL + lights[i].specular * specular.rgb * reflection);
+    }
+    FragColor = vec4(color, 1.0);
+}
@@ -7,6 +7,7 @@ in ATTRIB_OUT
 {
     vec3 position;
     vec2 texCoords;
+    flat int objectId;
 } attribIn[];
 
 out ATTRIB_VS_OUT
@@ -19,8 +20,20 @@ out ATTRIB_VS_OUT
 } attribOut;
 
 uniform mat4 view;
-uniform mat4 modelView;
-uniform mat3 normalMatrix;
+
+struct ObjectData
+{
+    mat4 mvp;
+    mat4 modelView;
+    mat3 normalMatrix;
+};
+
+// Matrices of the whole frame, indexed by the vertex shader
+const int MAX_OBJECTS = 4;
+layout (std140) uniform ObjectBlock
+{
+    ObjectData objects[MAX_OBJECTS];
+};
 
 struct Material
 {
@@ -86,6 +99,9 @@ void calcLightComponents(int idx, vec3 norm, vec3 lDir, vec3 vDir, out vec3 diff
 
 void main()
 {
+    mat4 modelView = objects[attribIn[0].objectId].modelView;
+    mat3 normalMatrix = objects[attribIn[0].objectId].normalMatrix;
+
     vec3 edge1 = attribIn[1].position - attribIn[0].position;
     vec3 edge2 = attribIn[2].position - attribIn[0].position;
     vec3 faceNormal = cross(edge1, edge2);
@@ -7,15 +7,29 @@ out ATTRIB_OUT
 {
     vec3 position;
     vec2 texCoords;
+    flat int objectId;
 } attribOut;
 
-uniform mat4 modelView;
-uniform mat4 mvp;
+struct ObjectData
+{
+    mat4 mvp;
+    mat4 modelView;
+    mat3 normalMatrix;
+};
+
+// Matrices of the whole frame, a draw reads objects[objectIndex + gl_InstanceID]
+const int MAX_OBJECTS = 4;
+layout (std140) uniform ObjectBlock
+{
+    ObjectData objects[MAX_OBJECTS];
+};
+uniform int objectIndex;
 
 void main()
 {
-    vec4 posView = modelView * vec4(position, 1.0);
-    gl_Position = mvp * vec4(position, 1.0);
+    int objectId = objectIndex + gl_InstanceID;
+    gl_Position = objects[objectId].mvp * vec4(position, 1.0);
     attribOut.texCoords = texCoords;
     attribOut.position  = position.xyz;
+    attribOut.objectId  = objectId;
 }
@@ -0,0 +1,63 @@
+#version 330 core
+
+in ATTRIB_VS_OUT
+{
+    vec2 texCoords;
+    vec3 normal;
+} attribIn;
+
+struct Material
+{
+    vec3 emission;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+
+struct UniversalLight
+{
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    vec3 position;
+    vec3 spotDirection;
+};
+
+layout (std140) uniform LightingBlock
+{
+    Material mat;
+    UniversalLight lights[3];
+    vec3 lightModelAmbient;
+    bool useBlinn;
+    bool useSpotlight;
+    bool useDirect3D;
+    float spotExponent;
+    float spotOpeningAngle;
+};
+
+uniform sampler2D diffuseSampler;
+uniform sampler2D specularSampler;
+
+// See GBuffer::Target
+layout (location = 0) out vec4 albedo;
+layout (location = 1) out vec4 specular;
+layout (location = 2) out vec4 normal;
+layout (location = 3) out vec4 emission;
+
+void main()
+{
+    vec3 diffuseTexel = texture(diffuseSampler, attribIn.texCoords).rgb;
+    float specularTexel = texture(specularSampler, attribIn.texCoords).r;
+
+    albedo = vec4(mat.diffuse * diffuseTexel, 1.0);
+    specular = vec4(mat.specular * specularTexel, mat.shininess);
+    normal = vec4(normalize(attribIn.normal), 0.0);
+
+    // The ambient terms don't depend on the light directions, they are
+    // summed here once
+    vec3 ambient = lightModelAmbient;
+    for (int i = 0; i < 3; i++)
+        ambient += lights[i].ambient;
+    emission = vec4(mat.emission + mat.ambient * diffuseTexel * ambient, 1.0);
+}
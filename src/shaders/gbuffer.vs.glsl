@@ -0,0 +1,34 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texCoords;
+layout (location = 2) in vec3 normal;
+
+out ATTRIB_VS_OUT
+{
+    vec2 texCoords;
+    vec3 normal;
+} attribOut;
+
+struct ObjectData
+{
+    mat4 mvp;
+    mat4 modelView;
+    mat3 normalMatrix;
+};
+
+// Matrices of the whole frame, a draw reads objects[objectIndex + gl_InstanceID]
+const int MAX_OBJECTS = 4;
+layout (std140) uniform ObjectBlock
+{
+    ObjectData objects[MAX_OBJECTS];
+};
+uniform int objectIndex;
+
+void main()
+{
+    ObjectData object = objects[objectIndex + gl_InstanceID];
+    gl_Position = object.mvp * vec4(position, 1.0);
+    attribOut.texCoords = texCoords;
+    attribOut.normal = object.normalMatrix * normal;
+}
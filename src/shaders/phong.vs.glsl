@@ -13,10 +13,22 @@ out ATTRIB_VS_OUT
     vec3 obsPos;
 } attribOut;
 
-uniform mat4 mvp;
 uniform mat4 view;
-uniform mat4 modelView;
-uniform mat3 normalMatrix;
+
+struct ObjectData
+{
+    mat4 mvp;
+    mat4 modelView;
+    mat3 normalMatrix;
+};
+
+// Matrices of the whole frame, a draw reads objects[objectIndex + gl_InstanceID]
+const int MAX_OBJECTS = 4;
+layout (std140) uniform ObjectBlock
+{
+    ObjectData objects[MAX_OBJECTS];
+};
+uniform int objectIndex;
 
 struct Material
 {
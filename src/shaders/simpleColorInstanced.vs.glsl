@@ -0,0 +1,10 @@
+#version 330 core
+
+uniform mat4 projView;
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in mat4 aModel;
+
+void main()
+{
+    gl_Position = projView * aModel * vec4(aPos, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+in vec2 vertexCoords;
+flat in float layer;
+out vec4 FragColor;
+
+uniform sampler2DArray tex;
+
+void main()
+{
+    vec4 texColor = texture(tex, vec3(vertexCoords, layer));
+    FragColor = texColor;
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec2 in_vertexCoords;
+layout(location = 3) in mat4 in_model;
+layout(location = 7) in float in_layer;
+
+out vec2 vertexCoords;
+flat out float layer;
+
+uniform mat4 projView;
+
+void main()
+{
+    gl_Position = projView * in_model * vec4(in_position, 1.0);
+    vertexCoords = in_vertexCoords;
+    layer = in_layer;
+}
@@ -0,0 +1,18 @@
+#version 430 core
+#extension GL_ARB_bindless_texture : require
+
+in vec2 vertexCoords;
+flat in float layer;
+out vec4 FragColor;
+
+// Handles of a BindlessTextureTable, indexed by the per-instance layer
+layout(std430, binding = 1) readonly buffer BindlessTextures
+{
+    uvec2 textures[];
+};
+
+void main()
+{
+    vec4 texColor = texture(sampler2D(textures[int(layer)]), vertexCoords);
+    FragColor = texColor;
+}
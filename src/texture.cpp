@@ -0,0 +1,152 @@
+#include "texture.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include "compressed_texture.h"
+#include "gl_state.h"
+
+size_t ImageData::dataSize() const
+{
+    if (!levels.empty())
+        return levels.back().offset + levels.back().size;
+    return size_t(width) * height * nChannels;
+}
+
+Texture2D::Texture2D(const char* path)
+: Texture2D(loadImage(path))
+{
+}
+
+Texture2D::Texture2D(const ImageData& image)
+: m_hasMipmap(false)
+, m_isCompressed(false)
+, m_bindlessHandle(0)
+{
+    glGenTextures(1, &m_id);
+    setImage(image, image.pixels.get());
+}
+
+Texture2D::Texture2D()
+: m_hasMipmap(false)
+, m_isCompressed(false)
+, m_bindlessHandle(0)
+{
+    const GLubyte grey[4] = { 128, 128, 128, 255 };
+    glGenTextures(1, &m_id);
+    setImage(1, 1, 4, grey);
+}
+
+ImageData Texture2D::loadImage(const char* path, bool allowCompressed)
+{
+    // Same value for every image, so setting stb's global from several threads is harmless
+    stbi_set_flip_vertically_on_load(true);
+
+    ImageData image = { 0, 0, 0, nullptr, 0, {} };
+
+    const std::string source = path;
+    const std::string base = source.substr(0, source.find_last_of('.'));
+    if (allowCompressed
+        && (loadCompressedImage((base + ".ktx").c_str(), image) || loadCompressedImage((base + ".dds").c_str(), image)))
+        return image;
+
+    image.pixels.reset(stbi_load(path, &image.width, &image.height, &image.nChannels, 0), stbi_image_free);
+    if (!image.pixels)
+        std::cout << "Error loading texture \"" << path << "\": " << stbi_failure_reason() << std::endl;
+    return image;
+}
+
+Texture2D::~Texture2D()
+{
+    if (m_bindlessHandle)
+        glMakeTextureHandleNonResidentARB(m_bindlessHandle);
+    GLState::deleteTexture(m_id);
+}
+
+void Texture2D::setFiltering(GLenum filteringMode)
+{
+    GLState::bindTexture(GL_TEXTURE_2D, m_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filteringMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filteringMode);
+}
+
+void Texture2D::setWrap(GLenum wrapMode)
+{
+    GLState::bindTexture(GL_TEXTURE_2D, m_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+}
+
+void Texture2D::enableMipmap()
+{
+    m_hasMipmap = true;
+    GLState::bindTexture(GL_TEXTURE_2D, m_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Compressed images come with their mip chain
+    if (!m_isCompressed)
+        glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void Texture2D::use(int i)
+{
+    GLState::bindTexture(i, GL_TEXTURE_2D, m_id);
+}
+
+GLuint64 Texture2D::getBindlessHandle()
+{
+    if (!m_bindlessHandle)
+    {
+        m_bindlessHandle = glGetTextureHandleARB(m_id);
+        glMakeTextureHandleResidentARB(m_bindlessHandle);
+    }
+    return m_bindlessHandle;
+}
+
+void Texture2D::setImage(int width, int height, int nChannels, const void* pixels)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLState::bindTexture(GL_TEXTURE_2D, m_id);
+
+    GLenum format = GL_RGBA;
+    switch (nChannels)
+    {
+    case 1: format = GL_RED; break;
+    case 2: format = GL_RG; break;
+    case 3: format = GL_RGB; break;
+    case 4: format = GL_RGBA; break;
+    }
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+    m_isCompressed = false;
+
+    if (m_hasMipmap)
+        glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void Texture2D::setImage(const ImageData& image, const void* data)
+{
+    if (image.compressedFormat == 0)
+    {
+        setImage(image.width, image.height, image.nChannels, data);
+        return;
+    }
+
+    GLState::bindTexture(GL_TEXTURE_2D, m_id);
+    const unsigned char* levels = static_cast<const unsigned char*>(data);
+    int width = image.width, height = image.height;
+    for (size_t level = 0; level < image.levels.size(); level++)
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, image.compressedFormat, width, height, 0,
+                               image.levels[level].size, levels + image.levels[level].offset);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    // Complete even without the whole chain
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levels.size() - 1);
+    m_isCompressed = true;
+}
@@ -2,12 +2,41 @@
 #define TEXTURES_H
 
 
+#include <memory>
+#include <vector>
+
 #include <GL/glew.h>
 
+// Decoded image, rows bottom to top as GL expects. Produced by
+// Texture2D::loadImage, which doesn't touch GL and may run on any thread.
+struct ImageData
+{
+	struct Level
+	{
+		size_t offset;
+		size_t size;
+	};
+
+	int width;
+	int height;
+	int nChannels;
+	std::shared_ptr<unsigned char> pixels; // null if the decoding failed
+
+	// Block compressed images only (see compressed_texture.h): the mip
+	// chain, stored one level after the other in pixels
+	GLenum compressedFormat; // 0 if uncompressed
+	std::vector<Level> levels;
+
+	size_t dataSize() const;
+};
+
 class Texture2D
 {
 public:
 	Texture2D(const char* path);
+	Texture2D(const ImageData& image);
+	// 1x1 grey placeholder, replaced later through setImage (see TextureStreamer)
+	Texture2D();
 	~Texture2D();
 	
 	void setFiltering(GLenum filteringMode);
@@ -17,8 +46,25 @@ public:
 
 	void use(int i = 0);
 
+	// Resident ARB_bindless_texture handle, created on the first call. The
+	// texture can't be modified afterwards (no setImage, no parameters).
+	GLuint64 getBindlessHandle();
+
+	// Reallocates the texture. pixels is an offset when a GL_PIXEL_UNPACK_BUFFER
+	// is bound. The mipmaps are regenerated if enableMipmap was called.
+	void setImage(int width, int height, int nChannels, const void* pixels);
+	// Same, data replacing image.pixels (compressed images keep their mip chain)
+	void setImage(const ImageData& image, const void* data);
+
+	// Prefers a block compressed version of the image next to it (same name,
+	// .ktx or .dds) when its format is supported and allowCompressed is set
+	static ImageData loadImage(const char* path, bool allowCompressed = true);
+
 private:
 	GLuint m_id;
+	bool m_hasMipmap;
+	bool m_isCompressed;
+	GLuint64 m_bindlessHandle;
 };
 
 
@@ -0,0 +1,123 @@
+#include "texture_array.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "gl_state.h"
+
+namespace
+{
+    // Bilinear, texel centers aligned like GL_LINEAR with GL_CLAMP_TO_EDGE
+    std::vector<unsigned char> resample(const ImageData& image, GLsizei width, GLsizei height)
+    {
+        const int n = image.nChannels;
+        const unsigned char* source = image.pixels.get();
+        std::vector<unsigned char> pixels(size_t(width) * height * n);
+
+        const float scaleX = float(image.width) / width, scaleY = float(image.height) / height;
+        for (GLsizei y = 0; y < height; y++)
+        {
+            const float sy = std::max(0.0f, (y + 0.5f) * scaleY - 0.5f);
+            const int y0 = std::min(int(sy), image.height - 1), y1 = std::min(y0 + 1, image.height - 1);
+            const float fy = sy - y0;
+            for (GLsizei x = 0; x < width; x++)
+            {
+                const float sx = std::max(0.0f, (x + 0.5f) * scaleX - 0.5f);
+                const int x0 = std::min(int(sx), image.width - 1), x1 = std::min(x0 + 1, image.width - 1);
+                const float fx = sx - x0;
+
+                const unsigned char* p00 = &source[(size_t(y0) * image.width + x0) * n];
+                const unsigned char* p10 = &source[(size_t(y0) * image.width + x1) * n];
+                const unsigned char* p01 = &source[(size_t(y1) * image.width + x0) * n];
+                const unsigned char* p11 = &source[(size_t(y1) * image.width + x1) * n];
+                unsigned char* out = &pixels[(size_t(y) * width + x) * n];
+                for (int c = 0; c < n; c++)
+                {
+                    const float top = p00[c] + (p10[c] - p00[c]) * fx;
+                    const float bottom = p01[c] + (p11[c] - p01[c]) * fx;
+                    out[c] = (unsigned char)(top + (bottom - top) * fy + 0.5f);
+                }
+            }
+        }
+        return pixels;
+    }
+}
+
+TextureArray::TextureArray(GLsizei width, GLsizei height, GLsizei layerCount)
+: m_width(width)
+, m_height(height)
+, m_layerCount(layerCount)
+, m_hasMipmap(false)
+{
+    glGenTextures(1, &m_id);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+}
+
+TextureArray::~TextureArray()
+{
+    GLState::deleteTexture(m_id);
+}
+
+void TextureArray::setLayer(GLint layer, const ImageData& image)
+{
+    if (!image.pixels || image.compressedFormat != 0 || layer >= m_layerCount)
+    {
+        std::cout << "Unable to set layer " << layer << " of a texture array" << std::endl;
+        return;
+    }
+
+    std::vector<unsigned char> resampled;
+    const unsigned char* pixels = image.pixels.get();
+    if (image.width != m_width || image.height != m_height)
+    {
+        resampled = resample(image, m_width, m_height);
+        pixels = resampled.data();
+    }
+
+    // GL fills the missing channels like for Texture2D (0 for green and blue, 1 for alpha)
+    GLenum format = GL_RGBA;
+    switch (image.nChannels)
+    {
+    case 1: format = GL_RED; break;
+    case 2: format = GL_RG; break;
+    case 3: format = GL_RGB; break;
+    case 4: format = GL_RGBA; break;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_width, m_height, 1, format, GL_UNSIGNED_BYTE, pixels);
+
+    if (m_hasMipmap)
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+void TextureArray::setFiltering(GLenum filteringMode)
+{
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filteringMode);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filteringMode);
+}
+
+void TextureArray::setWrap(GLenum wrapMode)
+{
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrapMode);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrapMode);
+}
+
+void TextureArray::enableMipmap()
+{
+    m_hasMipmap = true;
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+void TextureArray::use(int i)
+{
+    GLState::bindTexture(i, GL_TEXTURE_2D_ARRAY, m_id);
+}
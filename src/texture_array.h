@@ -0,0 +1,40 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <GL/glew.h>
+
+#include "texture.h"
+
+// Images of several objects in the layers of one GL_TEXTURE_2D_ARRAY, so
+// they share a single binding and can be drawn together; the layer is then
+// chosen per instance (see DrawBatch). Layers are RGBA8, images of another
+// size are resampled to the layer size.
+class TextureArray
+{
+public:
+    TextureArray(GLsizei width, GLsizei height, GLsizei layerCount);
+    ~TextureArray();
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    // Uncompressed images only
+    void setLayer(GLint layer, const ImageData& image);
+
+    void setFiltering(GLenum filteringMode);
+    void setWrap(GLenum wrapMode);
+
+    // Regenerated whenever a layer changes
+    void enableMipmap();
+
+    void use(int i = 0);
+
+private:
+    GLuint m_id;
+    GLsizei m_width;
+    GLsizei m_height;
+    GLsizei m_layerCount;
+    bool m_hasMipmap;
+};
+
+#endif // TEXTURE_ARRAY_H
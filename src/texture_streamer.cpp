@@ -0,0 +1,161 @@
+#include "texture_streamer.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "gl_state.h"
+
+TextureStreamer::TextureStreamer(AssetLoader& loader)
+: m_loader(loader)
+, m_buffer(0)
+, m_persistent(nullptr)
+, m_head(0)
+{
+    glGenBuffers(1, &m_buffer);
+    GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, RING_SIZE, nullptr, flags);
+        m_persistent = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, RING_SIZE, flags));
+    }
+    else
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, RING_SIZE, nullptr, GL_STREAM_DRAW);
+    }
+    GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    for (Segment& segment : m_segments)
+        glDeleteSync(segment.fence);
+
+    if (m_persistent)
+    {
+        GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    GLState::deleteBuffer(m_buffer);
+}
+
+void TextureStreamer::stream(Texture2D& texture, const char* path)
+{
+    m_requests.push_back({ &texture, m_loader.requestImage(path) });
+}
+
+bool TextureStreamer::isIdle() const
+{
+    return m_requests.empty();
+}
+
+void TextureStreamer::update()
+{
+    retireSegments();
+
+    for (auto it = m_requests.begin(); it != m_requests.end();)
+    {
+        if (it->image.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+
+        const ImageData& image = it->image.get();
+        if (!image.pixels)
+        {
+            // loadImage already reported it, the placeholder stays
+            it = m_requests.erase(it);
+            continue;
+        }
+
+        const GLsizeiptr size = image.dataSize();
+        if (size > RING_SIZE)
+        {
+            // Too big for the ring, uploaded from client memory instead
+            it->texture->setImage(image, image.pixels.get());
+            it = m_requests.erase(it);
+            continue;
+        }
+
+        GLintptr offset;
+        if (!allocate(size, offset))
+            break; // the ring is full until the GPU catches up
+
+        GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        std::memcpy(map(offset, size), image.pixels.get(), size);
+        unmap();
+        it->texture->setImage(image, reinterpret_cast<const void*>(offset));
+        GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        m_segments.push_back({ offset, size, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+        it = m_requests.erase(it);
+    }
+}
+
+// Frees the segments whose uploads the GPU has finished, in order
+void TextureStreamer::retireSegments()
+{
+    while (!m_segments.empty())
+    {
+        GLenum status = glClientWaitSync(m_segments.front().fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(m_segments.front().fence);
+        m_segments.pop_front();
+    }
+    if (m_segments.empty())
+        m_head = 0;
+}
+
+// Allocations are contiguous and in order: the free space is from m_head to
+// the oldest segment, wrapping around the end of the ring
+bool TextureStreamer::allocate(GLsizeiptr size, GLintptr& offset)
+{
+    if (m_segments.empty())
+    {
+        offset = 0;
+        m_head = size;
+        return true;
+    }
+
+    const GLintptr tail = m_segments.front().offset;
+    if (m_head > tail)
+    {
+        if (m_head + size <= RING_SIZE)
+        {
+            offset = m_head;
+            m_head += size;
+            return true;
+        }
+        if (size > tail)
+            return false;
+        offset = 0;
+        m_head = size;
+        return true;
+    }
+
+    if (m_head + size > tail)
+        return false;
+    offset = m_head;
+    m_head += size;
+    return true;
+}
+
+void* TextureStreamer::map(GLintptr offset, GLsizeiptr size)
+{
+    if (m_persistent)
+        return m_persistent + offset;
+
+    // The fences guarantee the range is no longer read by the GPU
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    return glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size, flags);
+}
+
+void TextureStreamer::unmap()
+{
+    if (!m_persistent)
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+}
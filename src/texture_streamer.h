@@ -0,0 +1,69 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <deque>
+#include <future>
+
+#include <GL/glew.h>
+
+#include "asset_loader.h"
+#include "texture.h"
+
+// Replaces placeholder textures by their image once decoded by the
+// AssetLoader. Pixels go through a ring of pixel unpack buffer space, so
+// glTexImage2D copies from GPU-visible memory and returns immediately.
+// Each upload fences its part of the ring; the ring is persistently mapped
+// when GL_ARB_buffer_storage is available, otherwise mapped unsynchronized
+// per upload. update() never waits on the GPU nor on the decoding.
+class TextureStreamer
+{
+public:
+    static const GLsizeiptr RING_SIZE = 16 << 20;
+
+    TextureStreamer(AssetLoader& loader);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // texture keeps what it shows (usually the Texture2D() placeholder)
+    // until the image at path is ready
+    void stream(Texture2D& texture, const char* path);
+
+    // Uploads the decoded images that fit in the free part of the ring, once per frame
+    void update();
+
+    bool isIdle() const;
+
+private:
+    struct Request
+    {
+        Texture2D* texture;
+        std::shared_future<ImageData> image;
+    };
+
+    struct Segment
+    {
+        GLintptr offset;
+        GLsizeiptr size;
+        GLsync fence;
+    };
+
+    void retireSegments();
+    bool allocate(GLsizeiptr size, GLintptr& offset);
+    void* map(GLintptr offset, GLsizeiptr size);
+    void unmap();
+
+private:
+    AssetLoader& m_loader;
+    GLuint m_buffer;
+    unsigned char* m_persistent;
+
+    // Segments in allocation order, the oldest is the first to be freed
+    std::deque<Segment> m_segments;
+    GLintptr m_head;
+
+    std::deque<Request> m_requests;
+};
+
+#endif // TEXTURE_STREAMER_H
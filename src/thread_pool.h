@@ -0,0 +1,52 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads consuming a FIFO of jobs.
+class ThreadPool
+{
+public:
+    // threadCount 0: one worker per hardware thread
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F job);
+
+    unsigned int size() const;
+
+private:
+    void push(std::function<void()> job);
+    void workerLoop();
+
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping;
+};
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::submit(F job)
+{
+    // std::function must be copyable, packaged_task is not
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(job));
+    std::future<std::invoke_result_t<F>> result = task->get_future();
+    push([task]() { (*task)(); });
+    return result;
+}
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,336 @@
+// Converts PNG/JPG images into KTX files of BCn blocks with their whole mip
+// chain, written next to each image with the .ktx extension. Texture2D::loadImage
+// then uses them instead of the originals.
+//   1 channel: BC4, 2 channels: BC5, RGB or opaque RGBA: BC1, RGBA: BC3
+// BC7 files made by other tools load as well, they just aren't produced here.
+//
+// Usage: texture_compress image...
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace
+{
+    struct Image
+    {
+        int width;
+        int height;
+        int nChannels;
+        std::vector<unsigned char> pixels;
+    };
+
+    // Box filter, the last row or column is repeated for odd sizes
+    Image downsample(const Image& source)
+    {
+        Image image = { std::max(1, source.width / 2), std::max(1, source.height / 2), source.nChannels, {} };
+        image.pixels.resize(size_t(image.width) * image.height * image.nChannels);
+        for (int y = 0; y < image.height; y++)
+        {
+            const int y0 = std::min(2 * y, source.height - 1), y1 = std::min(2 * y + 1, source.height - 1);
+            for (int x = 0; x < image.width; x++)
+            {
+                const int x0 = std::min(2 * x, source.width - 1), x1 = std::min(2 * x + 1, source.width - 1);
+                for (int c = 0; c < image.nChannels; c++)
+                {
+                    auto at = [&source, c](int sx, int sy) {
+                        return int(source.pixels[(size_t(sy) * source.width + sx) * source.nChannels + c]);
+                    };
+                    const int sum = at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1);
+                    image.pixels[(size_t(y) * image.width + x) * image.nChannels + c] = (sum + 2) / 4;
+                }
+            }
+        }
+        return image;
+    }
+
+    // 4x4 texels as RGBA, clamped to the edges of the image
+    void fetchBlock(const Image& image, int blockX, int blockY, unsigned char block[16][4])
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            const int x = std::min(blockX * 4 + i % 4, image.width - 1);
+            const int y = std::min(blockY * 4 + i / 4, image.height - 1);
+            const unsigned char* texel = &image.pixels[(size_t(y) * image.width + x) * image.nChannels];
+            for (int c = 0; c < 4; c++)
+                block[i][c] = c < image.nChannels ? texel[c] : (c == 3 ? 255 : 0);
+        }
+    }
+
+    uint16_t packRgb565(const float color[3])
+    {
+        auto quantize = [](float value, int maxValue) {
+            return unsigned(std::lround(std::min(std::max(value, 0.0f), 255.0f) * maxValue / 255.0f));
+        };
+        return uint16_t(quantize(color[0], 31) << 11 | quantize(color[1], 63) << 5 | quantize(color[2], 31));
+    }
+
+    void unpackRgb565(uint16_t packed, int color[3])
+    {
+        const int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = r << 3 | r >> 2;
+        color[1] = g << 2 | g >> 4;
+        color[2] = b << 3 | b >> 2;
+    }
+
+    void writeU16(unsigned char* out, uint16_t value)
+    {
+        out[0] = value & 0xFF;
+        out[1] = value >> 8;
+    }
+
+    // Endpoints at the extremes of the block along its principal axis
+    void encodeBC1(const unsigned char block[16][4], unsigned char out[8])
+    {
+        float mean[3] = { 0, 0, 0 };
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 3; c++)
+                mean[c] += block[i][c] / 16.0f;
+
+        float covariance[3][3] = {};
+        for (int i = 0; i < 16; i++)
+            for (int a = 0; a < 3; a++)
+                for (int b = 0; b < 3; b++)
+                    covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+
+        // Power iteration
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[3];
+            for (int a = 0; a < 3; a++)
+                next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+            const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+            if (length < 1e-6f)
+                break;
+            for (int a = 0; a < 3; a++)
+                axis[a] = next[a] / length;
+        }
+
+        float minT = 0.0f, maxT = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            const float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+
+        float high[3], low[3];
+        for (int c = 0; c < 3; c++)
+        {
+            high[c] = mean[c] + maxT * axis[c];
+            low[c] = mean[c] + minT * axis[c];
+        }
+        uint16_t color0 = packRgb565(high), color1 = packRgb565(low);
+        // color0 > color1 selects the four color mode
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        int palette[4][3];
+        unpackRgb565(color0, palette[0]);
+        unpackRgb565(color1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestDistance = 1 << 30;
+                for (int p = 0; p < 4; p++)
+                {
+                    int distance = 0;
+                    for (int c = 0; c < 3; c++)
+                        distance += (block[i][c] - palette[p][c]) * (block[i][c] - palette[p][c]);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= uint32_t(best) << (2 * i);
+            }
+        }
+
+        writeU16(out, color0);
+        writeU16(out + 2, color1);
+        for (int i = 0; i < 4; i++)
+            out[4 + i] = (indices >> (8 * i)) & 0xFF;
+    }
+
+    // One channel, endpoints at its extremes (eight value mode)
+    void encodeBC4(const unsigned char block[16][4], int channel, unsigned char out[8])
+    {
+        int high = 0, low = 255;
+        for (int i = 0; i < 16; i++)
+        {
+            high = std::max(high, int(block[i][channel]));
+            low = std::min(low, int(block[i][channel]));
+        }
+
+        int palette[8] = { high, low };
+        for (int p = 2; p < 8; p++)
+            palette[p] = ((8 - p) * high + (p - 1) * low + 3) / 7;
+
+        uint64_t indices = 0;
+        if (high != low)
+        {
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0;
+                for (int p = 1; p < 8; p++)
+                    if (std::abs(block[i][channel] - palette[p]) < std::abs(block[i][channel] - palette[best]))
+                        best = p;
+                indices |= uint64_t(best) << (3 * i);
+            }
+        }
+
+        out[0] = high;
+        out[1] = low;
+        for (int i = 0; i < 6; i++)
+            out[2 + i] = (indices >> (8 * i)) & 0xFF;
+    }
+
+    std::vector<unsigned char> compress(const Image& image, GLenum format)
+    {
+        const int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+        const size_t blockSize = (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RED_RGTC1) ? 8 : 16;
+
+        std::vector<unsigned char> blocks(size_t(blocksX) * blocksY * blockSize);
+        unsigned char* out = blocks.data();
+        unsigned char texels[16][4];
+        for (int y = 0; y < blocksY; y++)
+        {
+            for (int x = 0; x < blocksX; x++, out += blockSize)
+            {
+                fetchBlock(image, x, y, texels);
+                switch (format)
+                {
+                case GL_COMPRESSED_RED_RGTC1:
+                    encodeBC4(texels, 0, out);
+                    break;
+                case GL_COMPRESSED_RG_RGTC2:
+                    encodeBC4(texels, 0, out);
+                    encodeBC4(texels, 1, out + 8);
+                    break;
+                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                    encodeBC1(texels, out);
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                    encodeBC4(texels, 3, out);
+                    encodeBC1(texels, out + 8);
+                    break;
+                }
+            }
+        }
+        return blocks;
+    }
+
+    void writeU32(std::ofstream& out, uint32_t value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    bool convert(const char* path)
+    {
+        Image image = { 0, 0, 0, {} };
+        // Same orientation as Texture2D::loadImage
+        stbi_set_flip_vertically_on_load(true);
+        unsigned char* data = stbi_load(path, &image.width, &image.height, &image.nChannels, 0);
+        if (data == NULL)
+        {
+            std::cout << "Error loading \"" << path << "\": " << stbi_failure_reason() << std::endl;
+            return false;
+        }
+        image.pixels.assign(data, data + size_t(image.width) * image.height * image.nChannels);
+        stbi_image_free(data);
+
+        bool opaque = true;
+        if (image.nChannels == 4)
+            for (size_t i = 3; i < image.pixels.size(); i += 4)
+                opaque &= image.pixels[i] == 255;
+
+        GLenum format, baseFormat;
+        switch (image.nChannels)
+        {
+        case 1: format = GL_COMPRESSED_RED_RGTC1; baseFormat = GL_RED; break;
+        case 2: format = GL_COMPRESSED_RG_RGTC2; baseFormat = GL_RG; break;
+        case 3: format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; baseFormat = GL_RGB; break;
+        default:
+            format = opaque ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            baseFormat = opaque ? GL_RGB : GL_RGBA;
+            break;
+        }
+
+        const int width = image.width, height = image.height;
+        std::vector<std::vector<unsigned char>> levels;
+        levels.push_back(compress(image, format));
+        while (image.width > 1 || image.height > 1)
+        {
+            image = downsample(image);
+            levels.push_back(compress(image, format));
+        }
+
+        const std::string source = path;
+        const std::string outputPath = source.substr(0, source.find_last_of('.')) + ".ktx";
+        std::ofstream out(outputPath, std::ios::binary);
+        if (!out)
+        {
+            std::cout << "Unable to write \"" << outputPath << "\"" << std::endl;
+            return false;
+        }
+
+        const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+        out.write(reinterpret_cast<const char*>(identifier), sizeof(identifier));
+        writeU32(out, 0x04030201);
+        writeU32(out, 0); // glType
+        writeU32(out, 1); // glTypeSize
+        writeU32(out, 0); // glFormat
+        writeU32(out, format);
+        writeU32(out, baseFormat);
+        writeU32(out, width);
+        writeU32(out, height);
+        writeU32(out, 0); // pixelDepth
+        writeU32(out, 0); // numberOfArrayElements
+        writeU32(out, 1); // numberOfFaces
+        writeU32(out, levels.size());
+        writeU32(out, 0); // bytesOfKeyValueData
+        // Blocks are 8 or 16 bytes, the levels need no padding
+        for (const std::vector<unsigned char>& level : levels)
+        {
+            writeU32(out, level.size());
+            out.write(reinterpret_cast<const char*>(level.data()), level.size());
+        }
+
+        std::cout << path << " -> " << outputPath << std::endl;
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " image..." << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    for (int i = 1; i < argc; i++)
+        failures += !convert(argv[i]);
+    return failures == 0 ? 0 : 1;
+}
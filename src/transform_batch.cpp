@@ -0,0 +1,155 @@
+#include "transform_batch.h"
+
+#include "transform_kernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define TRANSFORM_BATCH_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    struct ScalarLanes
+    {
+        typedef float V;
+        static const size_t WIDTH = 1;
+
+        static V load(const float* p) { return *p; }
+        static V set1(float f) { return f; }
+        static V add(V a, V b) { return a + b; }
+        static V sub(V a, V b) { return a - b; }
+        static V mul(V a, V b) { return a * b; }
+        static V div(V a, V b) { return a / b; }
+        static void storeVec4(float* base, size_t stride, V x, V y, V z, V w)
+        {
+            base[0] = x;
+            base[1] = y;
+            base[2] = z;
+            base[3] = w;
+        }
+    };
+
+#ifdef TRANSFORM_BATCH_SSE
+    struct SseLanes
+    {
+        typedef __m128 V;
+        static const size_t WIDTH = 4;
+
+        static V load(const float* p) { return _mm_loadu_ps(p); }
+        static V set1(float f) { return _mm_set1_ps(f); }
+        static V add(V a, V b) { return _mm_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm_div_ps(a, b); }
+        // Transposes the 4 lanes of x, y, z, w into 4 vec4
+        static void storeVec4(float* base, size_t stride, V x, V y, V z, V w)
+        {
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(base, x);
+            _mm_storeu_ps(base + stride, y);
+            _mm_storeu_ps(base + 2 * stride, z);
+            _mm_storeu_ps(base + 3 * stride, w);
+        }
+    };
+#endif
+
+    bool hasAvx()
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        return __builtin_cpu_supports("avx");
+#else
+        return false;
+#endif
+    }
+}
+
+ObjectData computeObjectData(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& model)
+{
+    ObjectData object;
+    object.mvp = projView * model;
+    object.modelView = view * model;
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(object.modelView)));
+    for (int i = 0; i < 3; ++i)
+        object.normalMatrix[i] = glm::vec4(normalMatrix[i], 0.0f);
+    return object;
+}
+
+void TransformBatch::clear()
+{
+    for (std::vector<float>& coefficients : m_model)
+        coefficients.clear();
+}
+
+void TransformBatch::add(const glm::mat4& model)
+{
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 4; ++c)
+            m_model[r * 4 + c].push_back(model[c][r]);
+}
+
+size_t TransformBatch::size() const
+{
+    return m_model[0].size();
+}
+
+void TransformBatch::compute(const glm::mat4& projView, const glm::mat4& view, ObjectData* out, Isa isa) const
+{
+    if (size() == 0)
+        return;
+    if (isa == ISA_BEST)
+        isa = isSupported(ISA_AVX) ? ISA_AVX : isSupported(ISA_SSE) ? ISA_SSE : ISA_SCALAR;
+
+    const float* model[12];
+    for (int i = 0; i < 12; ++i)
+        model[i] = m_model[i].data();
+
+    const float* pv = &projView[0][0];
+    const float* v = &view[0][0];
+    const size_t count = size();
+    size_t done = 0;
+    if (isa == ISA_AVX && isSupported(ISA_AVX))
+        done = transformLanesAvx(model, count, pv, v, &out[0].mvp[0][0]);
+#ifdef TRANSFORM_BATCH_SSE
+    if (isa != ISA_SCALAR)
+    {
+        for (int i = 0; i < 12; ++i)
+            model[i] = m_model[i].data() + done;
+        done += transformLanes<SseLanes>(model, count - done, pv, v, &out[done].mvp[0][0]);
+    }
+#endif
+    for (int i = 0; i < 12; ++i)
+        model[i] = m_model[i].data() + done;
+    transformLanes<ScalarLanes>(model, count - done, pv, v, &out[done].mvp[0][0]);
+}
+
+bool TransformBatch::isSupported(Isa isa)
+{
+    switch (isa)
+    {
+    case ISA_SCALAR:
+    case ISA_BEST:
+        return true;
+    case ISA_SSE:
+#ifdef TRANSFORM_BATCH_SSE
+        return true;
+#else
+        return false;
+#endif
+    case ISA_AVX:
+        // transformLanesAvx does nothing without -mavx, the SSE path then takes over
+        return hasAvx();
+    }
+    return false;
+}
+
+const char* TransformBatch::getIsaName(Isa isa)
+{
+    switch (isa)
+    {
+    case ISA_SCALAR: return "scalar";
+    case ISA_SSE:    return "sse";
+    case ISA_AVX:    return "avx";
+    case ISA_BEST:   return "best";
+    }
+    return "";
+}
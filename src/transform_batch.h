@@ -0,0 +1,53 @@
+#ifndef TRANSFORM_BATCH_H
+#define TRANSFORM_BATCH_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// std140 layout of one element of ObjectBlock in the lighting shaders
+struct ObjectData
+{
+    glm::mat4 mvp;
+    glm::mat4 modelView;
+    glm::vec4 normalMatrix[3]; // mat3, columns padded
+};
+
+// Model matrices stored as structure of arrays, one array per coefficient of
+// their affine 3x4 part, so compute() derives the matrices of 4 (SSE) or
+// 8 (AVX) objects per iteration. The instruction set is chosen at runtime,
+// objects left over by the SIMD paths go through the scalar one.
+class TransformBatch
+{
+public:
+    enum Isa
+    {
+        ISA_SCALAR,
+        ISA_SSE,
+        ISA_AVX,
+        ISA_BEST
+    };
+
+    void clear();
+    // The last row of model must be (0, 0, 0, 1)
+    void add(const glm::mat4& model);
+    size_t size() const;
+
+    // out receives size() elements: projView * model, view * model and the
+    // inverse transpose of the 3x3 part of view * model
+    void compute(const glm::mat4& projView, const glm::mat4& view, ObjectData* out, Isa isa = ISA_BEST) const;
+
+    static bool isSupported(Isa isa);
+    static const char* getIsaName(Isa isa);
+
+private:
+    // m_model[row * 4 + column]
+    std::vector<float> m_model[12];
+};
+
+// Scalar glm reference of compute(), one object at a time, used by
+// bench/transform_bench.cpp to check and time the batch
+ObjectData computeObjectData(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& model);
+
+#endif // TRANSFORM_BATCH_H
@@ -0,0 +1,54 @@
+// Built with -mavx (see the makefile), only called after a runtime check
+#include "transform_kernel.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+
+namespace
+{
+    struct AvxLanes
+    {
+        typedef __m256 V;
+        static const size_t WIDTH = 8;
+
+        static V load(const float* p) { return _mm256_loadu_ps(p); }
+        static V set1(float f) { return _mm256_set1_ps(f); }
+        static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm256_div_ps(a, b); }
+        // Two 4x4 transposes, lanes 0-3 then 4-7
+        static void storeVec4(float* base, size_t stride, V x, V y, V z, V w)
+        {
+            for (int half = 0; half < 2; ++half)
+            {
+                __m128 x4 = half ? _mm256_extractf128_ps(x, 1) : _mm256_castps256_ps128(x);
+                __m128 y4 = half ? _mm256_extractf128_ps(y, 1) : _mm256_castps256_ps128(y);
+                __m128 z4 = half ? _mm256_extractf128_ps(z, 1) : _mm256_castps256_ps128(z);
+                __m128 w4 = half ? _mm256_extractf128_ps(w, 1) : _mm256_castps256_ps128(w);
+                _MM_TRANSPOSE4_PS(x4, y4, z4, w4);
+                float* p = base + half * 4 * stride;
+                _mm_storeu_ps(p, x4);
+                _mm_storeu_ps(p + stride, y4);
+                _mm_storeu_ps(p + 2 * stride, z4);
+                _mm_storeu_ps(p + 3 * stride, w4);
+            }
+        }
+    };
+}
+
+size_t transformLanesAvx(const float* const model[12], size_t count,
+                         const float* projView, const float* view, float* out)
+{
+    return transformLanes<AvxLanes>(model, count, projView, view, out);
+}
+
+#else
+
+size_t transformLanesAvx(const float* const model[12], size_t count,
+                         const float* projView, const float* view, float* out)
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef TRANSFORM_KERNEL_H
+#define TRANSFORM_KERNEL_H
+
+#include <cstddef>
+
+#include "transform_batch.h"
+
+// Lane-generic body of TransformBatch::compute(). Lanes provides the vector
+// type V, WIDTH, and load, set1, add, mul, sub, div and storeVec4 (lane i
+// written at base + i * stride floats). Each instruction set instantiates it
+// in its own translation unit, compiled with the matching flags.
+// Only raw floats cross this boundary: an inline glm function emitted by the
+// AVX translation unit could otherwise be the one kept by the linker.
+// projView and view are column major, out is an array of ObjectData.
+template <typename Lanes>
+size_t transformLanes(const float* const model[12], size_t count,
+                      const float* projView, const float* view, float* out)
+{
+    typedef typename Lanes::V V;
+    const size_t STRIDE = sizeof(ObjectData) / sizeof(float);
+    const size_t MVP = offsetof(ObjectData, mvp) / sizeof(float);
+    const size_t MODEL_VIEW = offsetof(ObjectData, modelView) / sizeof(float);
+    const size_t NORMAL_MATRIX = offsetof(ObjectData, normalMatrix) / sizeof(float);
+
+    size_t i = 0;
+    for (; i + Lanes::WIDTH <= count; i += Lanes::WIDTH)
+    {
+        V m[3][4];
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 4; ++c)
+                m[r][c] = Lanes::load(model[r * 4 + c] + i);
+
+        // a * model, the model's last row being (0, 0, 0, 1)
+        V mv[4][4], mvp[4][4];
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                V v = Lanes::mul(Lanes::set1(view[r]), m[0][c]);
+                v = Lanes::add(v, Lanes::mul(Lanes::set1(view[4 + r]), m[1][c]));
+                v = Lanes::add(v, Lanes::mul(Lanes::set1(view[8 + r]), m[2][c]));
+                V p = Lanes::mul(Lanes::set1(projView[r]), m[0][c]);
+                p = Lanes::add(p, Lanes::mul(Lanes::set1(projView[4 + r]), m[1][c]));
+                p = Lanes::add(p, Lanes::mul(Lanes::set1(projView[8 + r]), m[2][c]));
+                if (c == 3)
+                {
+                    v = Lanes::add(v, Lanes::set1(view[12 + r]));
+                    p = Lanes::add(p, Lanes::set1(projView[12 + r]));
+                }
+                mv[r][c] = v;
+                mvp[r][c] = p;
+            }
+        }
+
+        // inverse(A)^T = [a1 x a2, a2 x a0, a0 x a1] / det(A), a being the columns of A
+        V n[3][3];
+        for (int c = 0; c < 3; ++c)
+        {
+            const int c1 = (c + 1) % 3, c2 = (c + 2) % 3;
+            for (int r = 0; r < 3; ++r)
+            {
+                const int r1 = (r + 1) % 3, r2 = (r + 2) % 3;
+                n[r][c] = Lanes::sub(Lanes::mul(mv[r1][c1], mv[r2][c2]), Lanes::mul(mv[r2][c1], mv[r1][c2]));
+            }
+        }
+        V det = Lanes::mul(mv[0][0], n[0][0]);
+        det = Lanes::add(det, Lanes::mul(mv[1][0], n[1][0]));
+        det = Lanes::add(det, Lanes::mul(mv[2][0], n[2][0]));
+        const V invDet = Lanes::div(Lanes::set1(1.0f), det);
+
+        float* first = out + i * STRIDE;
+        const V zero = Lanes::set1(0.0f);
+        for (int c = 0; c < 4; ++c)
+        {
+            Lanes::storeVec4(first + MVP + c * 4, STRIDE, mvp[0][c], mvp[1][c], mvp[2][c], mvp[3][c]);
+            Lanes::storeVec4(first + MODEL_VIEW + c * 4, STRIDE, mv[0][c], mv[1][c], mv[2][c], mv[3][c]);
+        }
+        for (int c = 0; c < 3; ++c)
+            Lanes::storeVec4(first + NORMAL_MATRIX + c * 4, STRIDE, Lanes::mul(n[0][c], invDet),
+                             Lanes::mul(n[1][c], invDet), Lanes::mul(n[2][c], invDet), zero);
+    }
+    return i;
+}
+
+// Implemented in transform_batch_avx.cpp, returns the number of objects done
+// (0 when that file was not compiled with AVX enabled)
+size_t transformLanesAvx(const float* const model[12], size_t count,
+                         const float* projView, const float* view, float* out);
+
+#endif // TRANSFORM_KERNEL_H
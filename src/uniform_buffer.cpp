@@ -0,0 +1,26 @@
+#include "uniform_buffer.h"
+
+#include "gl_state.h"
+
+UniformBuffer::UniformBuffer(const void* data, GLsizeiptr byteSize)
+{
+    glGenBuffers(1, &m_ubo);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, byteSize, data, GL_DYNAMIC_DRAW);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GLState::deleteBuffer(m_ubo);
+}
+
+void UniformBuffer::setBindingIndex(GLuint index)
+{
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, index, m_ubo);
+}
+
+void UniformBuffer::updateData(const void* data, GLintptr offset, GLsizeiptr byteSize)
+{
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, byteSize, data);
+}
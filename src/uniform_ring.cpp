@@ -0,0 +1,125 @@
+#include "uniform_ring.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "gl_state.h"
+
+namespace
+{
+    GLsizeiptr alignUp(GLsizeiptr size, GLsizeiptr alignment)
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+}
+
+UniformRing::UniformRing(GLsizeiptr frameSize, int maxBlocksPerFrame)
+: m_ubo(0)
+, m_persistent(nullptr)
+, m_alignment(1)
+, m_regionSize(0)
+, m_fences{}
+, m_region(0)
+, m_head(0)
+{
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0)
+        m_alignment = alignment;
+    // Each block may waste up to an alignment of padding
+    m_regionSize = alignUp(frameSize + maxBlocksPerFrame * (m_alignment - 1), m_alignment);
+
+    const GLsizeiptr totalSize = m_regionSize * FRAME_COUNT;
+    glGenBuffers(1, &m_ubo);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, totalSize, nullptr, flags);
+        m_persistent = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, totalSize, flags));
+    }
+    else
+    {
+        glBufferData(GL_UNIFORM_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+UniformRing::~UniformRing()
+{
+    for (GLsync fence : m_fences)
+        if (fence)
+            glDeleteSync(fence);
+
+    if (m_persistent)
+    {
+        GLState::bindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    GLState::deleteBuffer(m_ubo);
+}
+
+void UniformRing::beginFrame()
+{
+    if (m_head > 0)
+    {
+        if (m_fences[m_region])
+            glDeleteSync(m_fences[m_region]);
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_region = (m_region + 1) % FRAME_COUNT;
+    }
+    m_head = 0;
+    waitRegion(m_region);
+}
+
+// Only blocks when the GPU is more than FRAME_COUNT - 1 frames behind
+void UniformRing::waitRegion(int region)
+{
+    if (!m_fences[region])
+        return;
+
+    GLenum status = glClientWaitSync(m_fences[region], 0, 0);
+    while (status == GL_TIMEOUT_EXPIRED)
+        status = glClientWaitSync(m_fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    glDeleteSync(m_fences[region]);
+    m_fences[region] = nullptr;
+}
+
+GLintptr UniformRing::write(const void* data, GLsizeiptr byteSize)
+{
+    const GLintptr offset = alignUp(m_head, m_alignment);
+    if (offset + byteSize > m_regionSize)
+    {
+        std::cout << "Uniform ring region full (" << m_regionSize << " bytes)" << std::endl;
+        return -1;
+    }
+    m_head = offset + byteSize;
+
+    const GLintptr bufferOffset = m_region * m_regionSize + offset;
+    if (m_persistent)
+    {
+        std::memcpy(m_persistent + bufferOffset, data, byteSize);
+    }
+    else
+    {
+        // The fences guarantee the range is no longer read by the GPU
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        GLState::bindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+        std::memcpy(glMapBufferRange(GL_UNIFORM_BUFFER, bufferOffset, byteSize, flags), data, byteSize);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    return bufferOffset;
+}
+
+void UniformRing::bindRange(GLuint index, GLintptr offset, GLsizeiptr byteSize)
+{
+    GLState::bindBufferRange(GL_UNIFORM_BUFFER, index, m_ubo, offset, byteSize);
+}
+
+bool UniformRing::bindData(GLuint index, const void* data, GLsizeiptr byteSize)
+{
+    const GLintptr offset = write(data, byteSize);
+    if (offset < 0)
+        return false;
+    bindRange(index, offset, byteSize);
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef UNIFORM_RING_H
+#define UNIFORM_RING_H
+
+#include <GL/glew.h>
+
+// Uniform buffer split in FRAME_COUNT regions, one per frame in flight. Each
+// block written during a frame gets its own aligned range of the current
+// region and is bound with glBindBufferRange, so a block rewritten for the
+// next draw never overwrites data a previous draw still reads. The regions
+// are fenced, a region is reused once the GPU is done with its frame.
+// The buffer is persistently mapped when GL_ARB_buffer_storage is available,
+// otherwise mapped unsynchronized per write.
+class UniformRing
+{
+public:
+    static const int FRAME_COUNT = 3;
+
+    // frameSize is the sum of the block sizes written in one frame
+    UniformRing(GLsizeiptr frameSize, int maxBlocksPerFrame);
+    ~UniformRing();
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    // Fences the previous region and moves to the next one, once per frame
+    void beginFrame();
+
+    // Copies the block in the current region, returns its offset or -1 when the region is full
+    GLintptr write(const void* data, GLsizeiptr byteSize);
+    void bindRange(GLuint index, GLintptr offset, GLsizeiptr byteSize);
+
+    // write() then bindRange()
+    bool bindData(GLuint index, const void* data, GLsizeiptr byteSize);
+
+private:
+    void waitRegion(int region);
+
+private:
+    GLuint m_ubo;
+    unsigned char* m_persistent;
+    GLsizeiptr m_alignment;
+    GLsizeiptr m_regionSize;
+
+    GLsync m_fences[FRAME_COUNT];
+    int m_region;
+    GLintptr m_head;
+};
+
+#endif // UNIFORM_RING_H
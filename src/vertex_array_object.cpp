@@ -0,0 +1,42 @@
+#include "vertex_array_object.h"
+
+#include "gl_state.h"
+
+VertexArrayObject::VertexArrayObject()
+{
+    glGenVertexArrays(1, &m_id);
+}
+
+VertexArrayObject::~VertexArrayObject()
+{
+    GLState::deleteVertexArray(m_id);
+}
+
+void VertexArrayObject::bind()
+{
+    GLState::bindVertexArray(m_id);
+}
+
+void VertexArrayObject::unbind()
+{
+    GLState::bindVertexArray(0);
+}
+
+void VertexArrayObject::specifyAttribute(BufferObject& buffer, GLuint index, GLint size, GLsizei stride, GLsizeiptr offset)
+{
+    specifyAttribute(buffer, index, size, GL_FLOAT, GL_FALSE, stride * sizeof(GLfloat), offset * sizeof(GLfloat));
+}
+
+void VertexArrayObject::specifyAttribute(BufferObject& buffer, GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, GLsizeiptr offset)
+{
+    bind();
+    buffer.bind();
+    glEnableVertexAttribArray(index);
+    glVertexAttribPointer(index, size, type, normalized, stride, (void*)offset);
+}
+
+void VertexArrayObject::setDivisor(GLuint index, GLuint divisor)
+{
+    bind();
+    glVertexAttribDivisor(index, divisor);
+}
@@ -12,7 +12,13 @@ public:
     void bind();
     void unbind();
     
+    // Float attribute, stride and offset counted in GLfloats
     void specifyAttribute(BufferObject& buffer, GLuint index, GLint size, GLsizei stride, GLsizeiptr offset);
+    // Any component type, stride and offset counted in bytes
+    void specifyAttribute(BufferObject& buffer, GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, GLsizeiptr offset);
+
+    // 0 advances the attribute per vertex, n every n instances
+    void setDivisor(GLuint index, GLuint divisor);
     
 private:
     GLuint m_id;
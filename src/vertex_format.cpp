@@ -0,0 +1,122 @@
+#include "vertex_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    const size_t VERTEX_SIZE = 8;
+}
+
+void computeBounds(const std::vector<GLfloat>& vertexData, size_t vertexSize, GLfloat boundsMin[3], GLfloat boundsMax[3])
+{
+    for (int k = 0; k < 3; ++k)
+    {
+        boundsMin[k] = vertexData.empty() ? 0.0f : vertexData[k];
+        boundsMax[k] = boundsMin[k];
+    }
+
+    for (size_t i = 0; i < vertexData.size(); i += vertexSize)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            boundsMin[k] = std::min(boundsMin[k], vertexData[i + k]);
+            boundsMax[k] = std::max(boundsMax[k], vertexData[i + k]);
+        }
+    }
+}
+
+GLfloat computeBoundingRadius(const std::vector<GLfloat>& vertexData, size_t vertexSize,
+                              const GLfloat boundsMin[3], const GLfloat boundsMax[3])
+{
+    GLfloat center[3];
+    for (int k = 0; k < 3; ++k)
+        center[k] = (boundsMin[k] + boundsMax[k]) * 0.5f;
+
+    GLfloat radius2 = 0.0f;
+    for (size_t i = 0; i < vertexData.size(); i += vertexSize)
+    {
+        GLfloat distance2 = 0.0f;
+        for (int k = 0; k < 3; ++k)
+            distance2 += (vertexData[i + k] - center[k]) * (vertexData[i + k] - center[k]);
+        radius2 = std::max(radius2, distance2);
+    }
+    return std::sqrt(radius2);
+}
+
+void quantizeVertices(const std::vector<GLfloat>& vertexData, const GLfloat boundsMin[3], const GLfloat boundsMax[3],
+                      std::vector<QuantizedVertex>& quantized)
+{
+    GLfloat invExtent[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        GLfloat extent = boundsMax[k] - boundsMin[k];
+        invExtent[k] = extent > 0.0f ? 1.0f / extent : 0.0f;
+    }
+
+    quantized.resize(vertexData.size() / VERTEX_SIZE);
+    for (size_t v = 0; v < quantized.size(); ++v)
+    {
+        const GLfloat* in = &vertexData[v * VERTEX_SIZE];
+        QuantizedVertex& out = quantized[v];
+
+        for (int k = 0; k < 3; ++k)
+        {
+            GLfloat t = std::clamp((in[k] - boundsMin[k]) * invExtent[k], 0.0f, 1.0f);
+            out.position[k] = GLushort(std::lround(t * 65535.0f));
+        }
+        out.position[3] = 0;
+
+        out.texCoords[0] = packHalf(in[3]);
+        out.texCoords[1] = packHalf(in[4]);
+
+        GLfloat length = std::sqrt(in[5] * in[5] + in[6] * in[6] + in[7] * in[7]);
+        GLfloat scale = length > 0.0f ? 1.0f / length : 0.0f;
+        out.normal = packSnorm1010102(in[5] * scale, in[6] * scale, in[7] * scale);
+    }
+}
+
+// IEEE 754 binary16, round to nearest even
+GLushort packHalf(GLfloat value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t absBits = bits & 0x7FFFFFFF;
+
+    if (absBits >= 0x7F800000) // inf or nan
+        return GLushort(sign | 0x7C00 | (absBits > 0x7F800000 ? 0x200 : 0));
+    if (absBits >= 0x477FF000) // overflows to inf
+        return GLushort(sign | 0x7C00);
+    if (absBits < 0x38800000) // subnormal or zero
+    {
+        if (absBits < 0x33000000)
+            return GLushort(sign);
+        const uint32_t mantissa = (absBits & 0x007FFFFF) | 0x00800000;
+        const int shift = 126 - int(absBits >> 23);
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            ++half;
+        return GLushort(sign | half);
+    }
+
+    uint32_t half = ((absBits - 0x38000000) >> 13);
+    const uint32_t rest = absBits & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        ++half;
+    return GLushort(sign | half);
+}
+
+GLuint packSnorm1010102(GLfloat x, GLfloat y, GLfloat z)
+{
+    auto pack = [](GLfloat v) -> GLuint
+    {
+        return GLuint(int(std::lround(std::clamp(v, -1.0f, 1.0f) * 511.0f))) & 0x3FF;
+    };
+    return pack(x) | (pack(y) << 10) | (pack(z) << 20);
+}
@@ -0,0 +1,32 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Compressed counterpart of Model's position (3), texCoords (2), normal (3)
+// float layout: 16 bytes instead of 32.
+//  - position: unsigned normalized 16 bits inside the mesh bounding box
+//  - texCoords: half floats
+//  - normal: signed normalized 10:10:10 (GL_INT_2_10_10_10_REV)
+struct QuantizedVertex
+{
+    GLushort position[4]; // xyz, w unused
+    GLushort texCoords[2];
+    GLuint normal;
+};
+
+void computeBounds(const std::vector<GLfloat>& vertexData, size_t vertexSize, GLfloat boundsMin[3], GLfloat boundsMax[3]);
+// Radius of the sphere centered on the bounding box enclosing every position
+GLfloat computeBoundingRadius(const std::vector<GLfloat>& vertexData, size_t vertexSize,
+                              const GLfloat boundsMin[3], const GLfloat boundsMax[3]);
+
+void quantizeVertices(const std::vector<GLfloat>& vertexData, const GLfloat boundsMin[3], const GLfloat boundsMax[3],
+                      std::vector<QuantizedVertex>& quantized);
+
+GLushort packHalf(GLfloat value);
+GLuint packSnorm1010102(GLfloat x, GLfloat y, GLfloat z);
+
+#endif // VERTEX_FORMAT_H
@@ -31,7 +31,7 @@ Window::~Window()
     SDL_Quit();
 }
     
-bool Window::init(bool vsync)
+bool Window::init(bool vsync, bool hidden)
 {
     const Uint32 flags = SDL_INIT_VIDEO | SDL_INIT_EVENTS;
     if (SDL_Init(flags) < 0)
@@ -53,7 +53,7 @@ bool Window::init(bool vsync)
     //SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
     //SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
     
-    m_window = SDL_CreateWindow("INF2705 - Tp", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 800, 800, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+    m_window = SDL_CreateWindow("INF2705 - Tp", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 800, 800, SDL_WINDOW_OPENGL | (hidden ? SDL_WINDOW_HIDDEN : SDL_WINDOW_RESIZABLE));
     if (!m_window)
     {
         std::cout << "Window could not be created! SDL_Error: " << SDL_GetError() << std::endl;
@@ -30,7 +30,8 @@ public:
     Window();
     ~Window();
     
-    bool init(bool vsync);
+    // hidden: never shown, for offscreen rendering
+    bool init(bool vsync, bool hidden = false);
     
     void swap();    
     void pollEvent();